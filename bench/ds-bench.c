@@ -0,0 +1,528 @@
+// microbenchmarks for ds.h
+//
+// every benchmark prints one json object per line:
+//   {"bench": ..., "n": ..., "ns_per_op": ..., "allocs_per_op": ...,
+//    "peak_rss_kb": ...}
+// allocations are counted with a counting allocator given to the
+// containers, peak_rss_kb is the peak resident set size of the whole
+// process so far (getrusage), so it only ever grows
+//
+// the largest size can be limited with the DS_BENCH_MAX_N environment
+// variable, it defaults to 10^7
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+// run enough repetitions so that every measurement covers this many ops
+#define BENCH_MIN_OPS 1000000L
+
+struct bench_counter_t {
+        long allocs;
+        long frees;
+};
+
+static void *bench_alloc(void *context, size_t size) {
+        ((struct bench_counter_t *)context)->allocs++;
+        return malloc(size);
+}
+
+static void *bench_realloc(void *context, void *ptr, size_t old_size,
+                           size_t new_size) {
+        (void)old_size;
+        ((struct bench_counter_t *)context)->allocs++;
+        return realloc(ptr, new_size);
+}
+
+static void bench_free(void *context, void *ptr, size_t size) {
+        (void)size;
+        if (ptr != NULL) {
+                ((struct bench_counter_t *)context)->frees++;
+        }
+        free(ptr);
+}
+
+static struct bench_counter_t counter;
+static struct ds_allocator_t allocator = {
+        bench_alloc, bench_realloc, bench_free, &counter
+};
+
+static double now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+}
+
+static long repetitions(long n) {
+        long reps = BENCH_MIN_OPS / n;
+        return reps < 1 ? 1 : reps;
+}
+
+// a measurement in progress
+struct bench_t {
+        const char *name;
+        long n;
+        long ops;
+        long allocs;
+        double ns;
+        double start;
+};
+
+static void bench_start(struct bench_t *bench) {
+        bench->allocs -= counter.allocs;
+        bench->start = now_ns();
+}
+
+static void bench_stop(struct bench_t *bench, long ops) {
+        bench->ns += now_ns() - bench->start;
+        bench->allocs += counter.allocs;
+        bench->ops += ops;
+}
+
+static void bench_report(struct bench_t *bench) {
+        printf("{\"bench\": \"%s\", \"n\": %ld, \"ns_per_op\": %.3f, "
+               "\"allocs_per_op\": %.6f, \"peak_rss_kb\": %ld}\n",
+               bench->name, bench->n, bench->ns / bench->ops,
+               (double)bench->allocs / bench->ops, peak_rss_kb());
+        fflush(stdout);
+}
+
+static void bench_vector(long n, int stride, const char *suffix) {
+        char name[64];
+        struct bench_t append = { 0 }, get = { 0 }, set = { 0 }, 
+                       pop = { 0 };
+        append.n = get.n = set.n = pop.n = n;
+        long reps = repetitions(n);
+        long checksum = 0;
+
+        for (long r = 0; r < reps; r++) {
+                struct vector_t vector;
+                vector_init_alloc(&vector, stride, &allocator);
+
+                bench_start(&append);
+                for (long i = 0; i < n; i++) {
+                        int value = (int)i;
+                        vector_append(&vector, &value, sizeof(value));
+                }
+                bench_stop(&append, n);
+
+                bench_start(&get);
+                for (long i = 0; i < n; i++) {
+                        int value;
+                        vector_get(&vector, (int)i, &value, sizeof(value));
+                        checksum += value;
+                }
+                bench_stop(&get, n);
+
+                bench_start(&set);
+                for (long i = 0; i < n; i++) {
+                        int value = (int)(n - i);
+                        vector_set(&vector, (int)i, &value, sizeof(value));
+                }
+                bench_stop(&set, n);
+
+                bench_start(&pop);
+                for (long i = 0; i < n; i++) {
+                        vector_pop(&vector);
+                }
+                bench_stop(&pop, n);
+
+                vector_delete(&vector);
+        }
+
+        snprintf(name, sizeof(name), "vector_append%s", suffix);
+        append.name = name;
+        bench_report(&append);
+        snprintf(name, sizeof(name), "vector_get%s", suffix);
+        get.name = name;
+        bench_report(&get);
+        snprintf(name, sizeof(name), "vector_set%s", suffix);
+        set.name = name;
+        bench_report(&set);
+        snprintf(name, sizeof(name), "vector_pop%s", suffix);
+        pop.name = name;
+        bench_report(&pop);
+
+        if (checksum == 42) {
+                printf("\n");
+        }
+}
+
+static void bench_packed_vector(long n) {
+        struct bench_t append = { 0 }, get = { 0 };
+        append.n = get.n = n;
+        append.name = "packed_vector_append";
+        get.name = "packed_vector_get";
+        long reps = repetitions(n);
+        long checksum = 0;
+
+        for (long r = 0; r < reps; r++) {
+                struct packed_vector_t vector;
+                packed_vector_init_alloc(&vector, &allocator);
+
+                bench_start(&append);
+                for (long i = 0; i < n; i++) {
+                        int value = (int)i;
+                        packed_vector_append(&vector, &value, sizeof(value));
+                }
+                bench_stop(&append, n);
+
+                bench_start(&get);
+                for (long i = 0; i < n; i++) {
+                        int value = 0;
+                        packed_vector_get(&vector, (int)i, &value, 
+                                          sizeof(value));
+                        checksum += value;
+                }
+                bench_stop(&get, n);
+
+                packed_vector_delete(&vector);
+        }
+
+        bench_report(&append);
+        bench_report(&get);
+
+        if (checksum == 42) {
+                printf("\n");
+        }
+}
+
+static int compare_int(const void *a, const void *b) {
+        int x = *(const int *)a;
+        int y = *(const int *)b;
+        return (x > y) - (x < y);
+}
+
+static void bench_vector_sort(long n) {
+        struct bench_t sort = { 0 }, stable = { 0 }, radix = { 0 }, 
+                       libc = { 0 };
+        sort.n = stable.n = radix.n = libc.n = n;
+        sort.name = "vector_sort";
+        stable.name = "vector_stable_sort";
+        radix.name = "vector_radix_sort";
+        libc.name = "qsort";
+        long reps = repetitions(n);
+
+        struct vector_t input;
+        vector_init_alloc(&input, sizeof(int), &allocator);
+        srand(42);
+        for (long i = 0; i < n; i++) {
+                int value = rand() - RAND_MAX / 2;
+                vector_append(&input, &value, sizeof(value));
+        }
+
+        struct bench_t *benches[] = { &sort, &stable, &radix, &libc };
+        for (int b = 0; b < 4; b++) {
+                for (long r = 0; r < reps; r++) {
+                        struct vector_t vector;
+                        vector_init_alloc(&vector, sizeof(int), &allocator);
+                        vector_append_many(&vector, input.data, (int)n, 
+                                           sizeof(int));
+
+                        bench_start(benches[b]);
+                        if (b == 0) {
+                                vector_sort(&vector, compare_int);
+                        } else if (b == 1) {
+                                vector_stable_sort(&vector, compare_int);
+                        } else if (b == 2) {
+                                vector_radix_sort(&vector, 0, sizeof(int), 1);
+                        } else {
+                                qsort(vector.data, n, sizeof(int), 
+                                      compare_int);
+                        }
+                        bench_stop(benches[b], n);
+
+                        vector_delete(&vector);
+                }
+                bench_report(benches[b]);
+        }
+
+        vector_delete(&input);
+}
+
+static void bench_priority_queue(long n) {
+        struct bench_t push = { 0 }, pop = { 0 };
+        push.n = pop.n = n;
+        push.name = "priority_queue_push";
+        pop.name = "priority_queue_pop";
+        long reps = repetitions(n);
+        long checksum = 0;
+
+        srand(42);
+        for (long r = 0; r < reps; r++) {
+                struct priority_queue_t queue;
+                priority_queue_init_alloc(&queue, sizeof(int), compare_int,
+                                          &allocator);
+
+                bench_start(&push);
+                for (long i = 0; i < n; i++) {
+                        int value = rand();
+                        priority_queue_push(&queue, &value, sizeof(value), 
+                                            NULL);
+                }
+                bench_stop(&push, n);
+
+                bench_start(&pop);
+                for (long i = 0; i < n; i++) {
+                        int value = 0;
+                        priority_queue_pop(&queue, &value, sizeof(value));
+                        checksum += value;
+                }
+                bench_stop(&pop, n);
+
+                priority_queue_delete(&queue);
+        }
+
+        bench_report(&push);
+        bench_report(&pop);
+
+        if (checksum == 42) {
+                printf("\n");
+        }
+}
+
+static void bench_btree_map(long n) {
+        struct bench_t put = { 0 }, get = { 0 }, scan = { 0 };
+        put.n = get.n = scan.n = n;
+        put.name = "btree_map_put";
+        get.name = "btree_map_get";
+        scan.name = "btree_map_scan";
+        long reps = repetitions(n);
+        long checksum = 0;
+
+        for (long r = 0; r < reps; r++) {
+                struct btree_map_t map;
+                btree_map_init_alloc(&map, sizeof(int), sizeof(int), 
+                                     compare_int, &allocator);
+
+                srand(42);
+                bench_start(&put);
+                for (long i = 0; i < n; i++) {
+                        int key = rand();
+                        btree_map_put(&map, &key, &key);
+                }
+                bench_stop(&put, n);
+
+                srand(42);
+                bench_start(&get);
+                for (long i = 0; i < n; i++) {
+                        int key = rand();
+                        int value = 0;
+                        btree_map_get(&map, &key, &value);
+                        checksum += value;
+                }
+                bench_stop(&get, n);
+
+                struct btree_iterator_t it;
+                void *value;
+                bench_start(&scan);
+                int err = btree_map_first(&map, &it, NULL, &value);
+                while (err == DS_NO_ERROR) {
+                        checksum += *(int *)value;
+                        err = btree_map_next(&it, NULL, &value);
+                }
+                bench_stop(&scan, map.count);
+
+                btree_map_delete(&map);
+        }
+
+        bench_report(&put);
+        bench_report(&get);
+        bench_report(&scan);
+
+        if (checksum == 42) {
+                printf("\n");
+        }
+}
+
+static void bench_bitset(long n) {
+        struct bench_t and_with = { 0 }, count = { 0 };
+        and_with.n = count.n = n;
+        and_with.name = "bitset_and_with";
+        count.name = "bitset_count";
+        long reps = repetitions(n);
+        size_t checksum = 0;
+
+        // n bits each, ops are counted per bit
+        struct bitset_t a, b;
+        bitset_init_alloc(&a, &allocator);
+        bitset_init_alloc(&b, &allocator);
+        srand(42);
+        for (long i = 0; i < n; i++) {
+                if (rand() & 1) {
+                        bitset_set(&a, i);
+                }
+                if (rand() & 1) {
+                        bitset_set(&b, i);
+                }
+        }
+        bitset_resize(&a, n);
+        bitset_resize(&b, n);
+
+        for (long r = 0; r < reps; r++) {
+                bench_start(&and_with);
+                bitset_and_with(&a, &b);
+                bench_stop(&and_with, n);
+
+                size_t bits;
+                bench_start(&count);
+                bitset_count(&a, &bits);
+                bench_stop(&count, n);
+                checksum += bits;
+        }
+
+        bench_report(&and_with);
+        bench_report(&count);
+        bitset_delete(&a);
+        bitset_delete(&b);
+
+        if (checksum == 42) {
+                printf("\n");
+        }
+}
+
+static void bench_string_builder(long n) {
+        struct bench_t appendc = { 0 }, append = { 0 }, appendf = { 0 },
+                       append_int = { 0 }, build = { 0 };
+        appendc.name = "string_builder_appendc";
+        append.name = "string_builder_append";
+        appendf.name = "string_builder_appendf";
+        append_int.name = "string_builder_append_int";
+        build.name = "string_builder_build";
+        appendc.n = append.n = appendf.n = append_int.n = build.n = n;
+        long reps = repetitions(n);
+
+        for (long r = 0; r < reps; r++) {
+                struct string_builder_t sb;
+
+                string_builder_init_alloc(&sb, &allocator);
+                bench_start(&appendc);
+                for (long i = 0; i < n; i++) {
+                        string_builder_appendc(&sb, 'a' + i % 26);
+                }
+                bench_stop(&appendc, n);
+                string_builder_delete(&sb);
+
+                string_builder_init_alloc(&sb, &allocator);
+                bench_start(&append);
+                for (long i = 0; i < n; i++) {
+                        string_builder_append(&sb, "word ");
+                }
+                bench_stop(&append, n);
+                string_builder_delete(&sb);
+
+                string_builder_init_alloc(&sb, &allocator);
+                bench_start(&appendf);
+                for (long i = 0; i < n; i++) {
+                        string_builder_appendf(&sb, "%ld,", i);
+                }
+                bench_stop(&appendf, n);
+                string_builder_delete(&sb);
+
+                string_builder_init_alloc(&sb, &allocator);
+                bench_start(&append_int);
+                for (long i = 0; i < n; i++) {
+                        string_builder_append_i64(&sb, i);
+                        string_builder_appendc(&sb, ',');
+                }
+                bench_stop(&append_int, n);
+
+                // build cost is reported per character of the result
+                char *str;
+                bench_start(&build);
+                string_builder_build(&sb, &str);
+                bench_stop(&build, sb.count);
+                ds_free(sb.allocator, str, sb.count + 1);
+                string_builder_delete(&sb);
+        }
+
+        bench_report(&appendc);
+        bench_report(&append);
+        bench_report(&appendf);
+        bench_report(&append_int);
+        bench_report(&build);
+}
+
+#define BENCH_AP_OPTIONS 32
+
+static void bench_ap_parser(long n) {
+        struct bench_t parse = { 0 };
+        parse.name = "ap_parser_parse";
+        parse.n = n;
+        long reps = repetitions(n);
+
+        // options are named -a .. and --option-0 .., the last ones are used
+        // most so a linear scan has to walk the whole list
+        static char names[BENCH_AP_OPTIONS][2][32];
+        struct ap_argument_t arguments[BENCH_AP_OPTIONS];
+        for (int i = 0; i < BENCH_AP_OPTIONS; i++) {
+                snprintf(names[i][0], sizeof(names[i][0]), "-%c", 'A' + i);
+                snprintf(names[i][1], sizeof(names[i][1]), "--option-%d", i);
+                ap_argument_init(&arguments[i], i % 2 ? AP_FVALUE : AP_FLAG,
+                                 names[i][0], names[i][1], "benchmark");
+        }
+
+        // every option with a value consumes two tokens
+        const char **argv = malloc((n + 2) * sizeof(char *));
+        long argc = 1;
+        argv[0] = "bench";
+        for (long i = 0; argc < n + 1; i++) {
+                int option = BENCH_AP_OPTIONS - 1 - (int)(i % 4);
+                argv[argc++] = names[option][i % 3 == 0];
+                if (arguments[option].type == AP_FVALUE) {
+                        argv[argc++] = "value";
+                }
+        }
+
+        for (long r = 0; r < reps; r++) {
+                struct ap_parser_t parser;
+                ap_parser_init_alloc(&parser, "bench", "0", "benchmark",
+                                     &allocator);
+                for (int i = 0; i < BENCH_AP_OPTIONS; i++) {
+                        ap_parser_add_argument(&parser, &arguments[i]);
+                }
+
+                bench_start(&parse);
+                ap_parser_parse(&parser, (int)argc, argv);
+                bench_stop(&parse, argc - 1);
+
+                ap_parser_delete(&parser);
+        }
+
+        bench_report(&parse);
+        free(argv);
+}
+
+int main() {
+        long max_n = 10000000;
+        const char *env = getenv("DS_BENCH_MAX_N");
+        if (env != NULL) {
+                max_n = atol(env);
+        }
+
+        for (long n = 10; n <= max_n; n *= 10) {
+                bench_vector(n, 0, "");
+                bench_vector(n, sizeof(int), "_fixed");
+                bench_packed_vector(n);
+                bench_vector_sort(n);
+                bench_priority_queue(n);
+                bench_btree_map(n);
+                bench_bitset(n);
+                bench_string_builder(n);
+                bench_ap_parser(n);
+        }
+
+        return 0;
+}
@@ -5,6 +5,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <stdint.h>
+
+// the queues and the segmented vector need C11 atomics, they are left out
+// when the compiler has none (C++ included) or DS_NO_THREADS is defined
+#if !defined(DS_NO_THREADS) && !defined(__cplusplus) && \
+    defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+    !defined(__STDC_NO_ATOMICS__)
+#define DS__HAS_ATOMICS
+#include <stdatomic.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 enum ds_error_enum {
         DS_NO_ERROR = 0,        // when there is no error
@@ -15,40 +34,664 @@ enum ds_error_enum {
         DS_RANGE_ERROR,         // index out of range error
         DS_EXPECTED_ERROR,      // something more expected
         DS_SOMETHING_WENT_WRONG,// soemthing went wrong
+        DS_NOT_FOUND_ERROR,     // key or item is not present
+        DS_IO_ERROR,            // reading or writing a file failed
+        DS_FULL_ERROR,          // adding items when there is no room
+        DS_READ_ONLY_ERROR,     // writing to a read only mapping
+        DS_FORMAT_ERROR,        // a file is not in the expected format
         DS_NUM_OF_ERRORS        // this is not an error
 };
 
 void ds_print_error(enum ds_error_enum);
 
+// allocator
+//
+// every container allocates through an allocator, which is a set of
+// functions plus a context pointer passed back to them
+// a NULL allocator means the standard malloc, realloc and free
+// the size of the block is always passed back on realloc and free,
+// so simple allocators do not need to remember it
+struct ds_allocator_t {
+        void *(*alloc_fn)(void *context, size_t size);
+        void *(*realloc_fn)(void *context, void *ptr, size_t old_size,
+                            size_t new_size);
+        void  (*free_fn)(void *context, void *ptr, size_t size);
+        void *context;
+};
+
+void *ds_alloc(const struct ds_allocator_t *allocator, size_t size);
+void *ds_realloc(const struct ds_allocator_t *allocator, void *ptr,
+                 size_t old_size, size_t new_size);
+void  ds_free(const struct ds_allocator_t *allocator, void *ptr, 
+              size_t size);
+
+// arena
+//
+// arena is a bump pointer allocator
+// memory is handed out from large blocks and is never freed one by one,
+// instead the arena is reset to a mark (or emptied) in a single step
+// arena->allocator can be given to any container, the arena must not be
+// moved after ds_arena_init since the allocator points back to it
+struct ds_arena_block_t;
+
+struct ds_arena_t {
+        struct ds_arena_block_t *head;  // newest block
+        size_t block_size;              // default size of new blocks
+        struct ds_allocator_t allocator;
+};
+
+struct ds_arena_mark_t {
+        struct ds_arena_block_t *block;
+        size_t used;
+};
+
+#ifndef DS_ARENA_BLOCK_SIZE
+#define DS_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+int   ds_arena_init(struct ds_arena_t *arena, size_t block_size);
+void *ds_arena_alloc(struct ds_arena_t *arena, size_t size);
+void *ds_arena_alloc_bytes(struct ds_arena_t *arena, size_t size);
+int   ds_arena_mark(struct ds_arena_t *arena, struct ds_arena_mark_t *mark);
+int   ds_arena_reset(struct ds_arena_t *arena, 
+                     const struct ds_arena_mark_t *mark);
+int   ds_arena_delete(struct ds_arena_t *arena);
+
+// stats
+//
+// define DS_STATS before including ds.h to count what the containers do
+// with the heap, globally and per container (through the name_stats
+// function of each container); without DS_STATS nothing is counted and
+// the containers carry no extra fields, the stats functions then report
+// zeros
+// the global counters are not thread safe
+struct ds_stats_t {
+        long long mallocs;        // allocations and reallocations
+        long long frees;
+        long long bytes_allocated;// total bytes requested
+        long long live_bytes;     // bytes currently allocated
+        long long high_water;     // highest live_bytes seen
+        long long grows;          // capacity growth events
+        long long memcpy_bytes;   // bytes copied in and out
+};
+
+int ds_stats_snapshot(struct ds_stats_t *stats);
+int ds_stats_reset(void);
+int ds_stats_dump(FILE *out, const char *label, 
+                  const struct ds_stats_t *stats);
+
+#ifdef DS_STATS
+#define DS__STATS_MEMBER struct ds_stats_t stats;
+#else
+#define DS__STATS_MEMBER
+#endif
+
 // vector
 //
 // vector is an array that grows dynamically
-// implementation wise the array grows 8 items at a time
+// implementation wise the capacity is multiplied by a growth factor
+// (DS_VECTOR_GROWTH_FACTOR by default) every time it is full, so
+// appending n items costs amortized O(1) per item
 // this is a generic implementation and can be used with any type
+//
+// a vector initialized with vector_init stores every item in its own
+// allocation, so items of different sizes can live in the same vector
+// a vector initialized with vector_init_fixed stores items of one fixed
+// size (the stride) inline in a single contiguous buffer
+// vector_init_alloc does either (stride 0 means variable sized items)
+// with a custom allocator
 struct vector_t {
-        void **items;
-        int  *sizes;
+        void **items;   // per item allocations when stride is 0
+        int  *sizes;    // per item sizes when stride is 0
+        char *data;     // contiguous item storage when stride > 0
+        int  stride;    // fixed item size, 0 for variable sized items
         int  count;
         int  capacity;
+        double growth_factor;
+        const struct ds_allocator_t *allocator;
+        void  *map;     // file mapping from vector_open, NULL otherwise
+        size_t map_size;
+        int   read_only;
+        DS__STATS_MEMBER
 };
 
+#ifndef DS_VECTOR_GROWTH_FACTOR
+#define DS_VECTOR_GROWTH_FACTOR 2.0
+#endif
+
+#ifndef DS_VECTOR_MIN_CAPACITY
+#define DS_VECTOR_MIN_CAPACITY 8
+#endif
+
 int vector_init(struct vector_t *vector);
+int vector_init_fixed(struct vector_t *vector, int stride);
+int vector_init_alloc(struct vector_t *vector, int stride,
+                      const struct ds_allocator_t *allocator);
+int vector_set_growth_factor(struct vector_t *vector, double factor);
+int vector_reserve(struct vector_t *vector, int capacity);
+int vector_shrink_to_fit(struct vector_t *vector);
+int vector_clear(struct vector_t *vector);
 int vector_append(struct vector_t *vector, void *item, int size);
 int vector_top(struct vector_t *vector, void *item, int size);
 int vector_pop(struct vector_t *vector);
 int vector_get(struct vector_t *vector, int index, void *item, int size);
 int vector_set(struct vector_t *vector, int index, void *item, int size);
+int vector_append_many(struct vector_t *vector, void *items, int count,
+                       int size);
+int vector_get_range(struct vector_t *vector, int index, int count, 
+                     void *items, int size);
+int vector_set_range(struct vector_t *vector, int index, int count, 
+                     void *items, int size);
+int vector_insert(struct vector_t *vector, int index, void *item, int size);
+int vector_erase(struct vector_t *vector, int index, int count);
+int vector_resize(struct vector_t *vector, int count);
 int vector_delete(struct vector_t *vector);
+int vector_stats(struct vector_t *vector, struct ds_stats_t *stats);
+
+// sorting and searching
+//
+// compare gets two items (or the key and an item for the searches) and
+// returns < 0, 0 or > 0 like the qsort comparator
+// vector_sort is an introsort that moves the items in place, vector
+// stable_sort keeps equal items in order and needs count extra items of
+// scratch space, both switch to a parallel merge sort on
+// DS_PARALLEL_SORT_MIN items or more (unless DS_NO_THREADS is defined)
+// vector_radix_sort is a stable least significant digit sort for fixed
+// stride vectors, keyed on a 1, 2, 4 or 8 byte integer at key_offset
+// the searches expect a vector sorted with the same compare
+#ifndef DS_PARALLEL_SORT_MIN
+#define DS_PARALLEL_SORT_MIN (1 << 16)
+#endif
+
+#ifndef DS_SORT_MAX_THREADS
+#define DS_SORT_MAX_THREADS 8
+#endif
+
+int vector_sort(struct vector_t *vector, 
+                int (*compare)(const void *a, const void *b));
+int vector_stable_sort(struct vector_t *vector, 
+                       int (*compare)(const void *a, const void *b));
+int vector_radix_sort(struct vector_t *vector, int key_offset, int key_size,
+                      int is_signed);
+int vector_bsearch(struct vector_t *vector, const void *key,
+                   int (*compare)(const void *key, const void *item),
+                   int *index);
+int vector_lower_bound(struct vector_t *vector, const void *key,
+                       int (*compare)(const void *key, const void *item),
+                       int *index);
+
+// vector files
+//
+// vector_save writes a fixed stride vector to a file: a 64 byte header
+// (magic, version, stride, count, checksum) followed by the items, in the
+// byte order of the machine that wrote it
+// vector_open maps such a file and points the vector at it, nothing is
+// read or copied until the items are touched
+// VECTOR_MAP_READ_ONLY vectors refuse every write with DS_READ_ONLY_ERROR
+// VECTOR_MAP_COPY_ON_WRITE vectors can be written in place without
+// changing the file, growing them copies the items to the heap
+// VECTOR_MAP_VERIFY checks the checksum while opening, which reads the
+// whole file
+// vector_delete unmaps the file
+#define DS_VECTOR_FILE_VERSION 1
+
+enum vector_map_enum {
+        VECTOR_MAP_READ_ONLY     = 0,
+        VECTOR_MAP_COPY_ON_WRITE = 1 << 0,
+        VECTOR_MAP_VERIFY        = 1 << 1,
+};
+
+int vector_save(struct vector_t *vector, const char *path);
+int vector_open(struct vector_t *vector, const char *path, int flags);
+
+// packed vector
+//
+// packed vector holds items of different sizes like vector_init, but all
+// the items live back to back in one byte buffer with an (offset, size)
+// entry per item, so appends cost no allocation of their own
+// setting an item that fits overwrites it in place, a bigger item is
+// appended at the end and its old bytes become dead space
+// packed_vector_compact packs the live items again, it also runs on its
+// own before the buffer would grow while at least half of it is dead
+// pointers from packed_vector_at are only byte aligned and are valid
+// until the next append, set or compact, but the item passed to append
+// or set may point into the vector itself
+struct ds__packed_entry_t {
+        size_t offset;
+        int    size;
+};
+
+struct packed_vector_t {
+        char  *bytes;
+        size_t used;            // bytes in use, dead ones included
+        size_t dead;            // bytes of overwritten items
+        size_t bytes_capacity;
+        struct ds__packed_entry_t *entries;
+        int    count;
+        int    capacity;
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int packed_vector_init(struct packed_vector_t *vector);
+int packed_vector_init_alloc(struct packed_vector_t *vector,
+                             const struct ds_allocator_t *allocator);
+int packed_vector_reserve(struct packed_vector_t *vector, int count,
+                          size_t bytes);
+int packed_vector_append(struct packed_vector_t *vector, const void *item,
+                         int size);
+int packed_vector_get(struct packed_vector_t *vector, int index, void *item,
+                      int size);
+int packed_vector_at(struct packed_vector_t *vector, int index, void **item,
+                     int *size);
+int packed_vector_set(struct packed_vector_t *vector, int index, 
+                      const void *item, int size);
+int packed_vector_pop(struct packed_vector_t *vector);
+int packed_vector_compact(struct packed_vector_t *vector);
+int packed_vector_clear(struct packed_vector_t *vector);
+int packed_vector_delete(struct packed_vector_t *vector);
+int packed_vector_stats(struct packed_vector_t *vector, 
+                        struct ds_stats_t *stats);
+
+// priority queue
+//
+// priority queue is a 4-ary heap of fixed size items kept in one
+// contiguous buffer, items are moved with memcpy only
+// compare returns < 0 when a has to come out before b, so a qsort style
+// comparator gives the smallest item first
+// every pushed item gets a handle that stays the same while the item
+// moves around the heap, it can be used to change (decrease-key) or
+// remove the item until it is popped, then the handle is reused
+struct priority_queue_t {
+        char *data;             // capacity items and one scratch item
+        int  *handles;          // handle of the item at each position
+        int  *positions;        // position of each handle, < 0 when free
+        int  stride;
+        int  count;
+        int  capacity;
+        int  handle_count;      // handles handed out so far
+        int  free_handle;       // first free handle, -1 if none
+        int (*compare)(const void *a, const void *b);
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int priority_queue_init(struct priority_queue_t *queue, int stride,
+                        int (*compare)(const void *a, const void *b));
+int priority_queue_init_alloc(struct priority_queue_t *queue, int stride,
+                              int (*compare)(const void *a, const void *b),
+                              const struct ds_allocator_t *allocator);
+int priority_queue_reserve(struct priority_queue_t *queue, int capacity);
+int priority_queue_heapify(struct priority_queue_t *queue, const void *items,
+                           int count, int size);
+int priority_queue_push(struct priority_queue_t *queue, const void *item, 
+                        int size, int *handle);
+int priority_queue_peek(struct priority_queue_t *queue, void *item, 
+                        int size);
+int priority_queue_pop(struct priority_queue_t *queue, void *item, int size);
+int priority_queue_get(struct priority_queue_t *queue, int handle, 
+                       void *item, int size);
+int priority_queue_update(struct priority_queue_t *queue, int handle, 
+                          const void *item, int size);
+int priority_queue_remove(struct priority_queue_t *queue, int handle);
+int priority_queue_clear(struct priority_queue_t *queue);
+int priority_queue_delete(struct priority_queue_t *queue);
+int priority_queue_stats(struct priority_queue_t *queue, 
+                         struct ds_stats_t *stats);
+
+// deque
+//
+// deque is a double ended queue of fixed size items in a circular buffer
+// the capacity is always a power of two so positions wrap with a mask,
+// when full the items are unwrapped into a buffer twice as big
+// pushing and popping at either end never moves the other items
+struct deque_t {
+        char *data;
+        int  stride;
+        int  head;      // position of the front item
+        int  count;
+        int  capacity;  // 0 or a power of two
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int deque_init(struct deque_t *deque, int stride);
+int deque_init_alloc(struct deque_t *deque, int stride,
+                     const struct ds_allocator_t *allocator);
+int deque_reserve(struct deque_t *deque, int capacity);
+int deque_push_back(struct deque_t *deque, const void *item, int size);
+int deque_push_front(struct deque_t *deque, const void *item, int size);
+int deque_push_back_many(struct deque_t *deque, const void *items, 
+                         int count, int size);
+int deque_pop_back(struct deque_t *deque, void *item, int size);
+int deque_pop_front(struct deque_t *deque, void *item, int size);
+int deque_pop_front_many(struct deque_t *deque, void *items, int count,
+                         int size, int *popped);
+int deque_front(struct deque_t *deque, void *item, int size);
+int deque_back(struct deque_t *deque, void *item, int size);
+int deque_get(struct deque_t *deque, int index, void *item, int size);
+int deque_set(struct deque_t *deque, int index, const void *item, int size);
+int deque_clear(struct deque_t *deque);
+int deque_delete(struct deque_t *deque);
+int deque_stats(struct deque_t *deque, struct ds_stats_t *stats);
+
+// typed vector
+//
+// DS_VECTOR_DEFINE(name, T) generates a vector of T named struct name_t
+// with the functions below, all defined static inline in place
+//
+//   int name_init(struct name_t *v);
+//   int name_init_alloc(struct name_t *v, const struct ds_allocator_t *a);
+//   int name_reserve(struct name_t *v, int capacity);
+//   int name_push(struct name_t *v, T item);
+//   int name_pop(struct name_t *v, T *item);        // item may be NULL
+//   int name_get(struct name_t *v, int index, T *item);
+//   int name_set(struct name_t *v, int index, T item);
+//   T  *name_at(struct name_t *v, int index);       // no range check
+//   T  *name_data(struct name_t *v);
+//   int name_count(struct name_t *v);
+//   int name_clear(struct name_t *v);
+//   int name_delete(struct name_t *v);
+//
+// since the item size is known at compile time, the compiler can inline
+// and vectorize loops over name_data, unlike the generic vector_t
+#define DS_VECTOR_DEFINE(name, T)                                             \
+struct name##_t {                                                             \
+        T   *data;                                                            \
+        int count;                                                            \
+        int capacity;                                                         \
+        const struct ds_allocator_t *allocator;                               \
+};                                                                            \
+                                                                              \
+static inline int name##_init_alloc(struct name##_t *v,                       \
+                                    const struct ds_allocator_t *allocator) { \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        v->data = NULL;                                                       \
+        v->count = 0;                                                         \
+        v->capacity = 0;                                                      \
+        v->allocator = allocator;                                             \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_init(struct name##_t *v) {                           \
+        return name##_init_alloc(v, NULL);                                    \
+}                                                                             \
+                                                                              \
+static inline int name##_reserve(struct name##_t *v, int capacity) {          \
+        if (v == NULL || capacity < 0) {                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        if (capacity <= v->capacity) {                                        \
+                return DS_NO_ERROR;                                           \
+        }                                                                     \
+        T *temp = (T *)ds_realloc(v->allocator, v->data,                      \
+                                  (size_t)v->capacity * sizeof(T),            \
+                                  (size_t)capacity * sizeof(T));              \
+        if (temp == NULL) {                                                   \
+                return DS_MALLOC_ERROR;                                       \
+        }                                                                     \
+        v->data = temp;                                                       \
+        v->capacity = capacity;                                               \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static int name##_grow_(struct name##_t *v) {                                 \
+        int capacity = v->capacity < DS_VECTOR_MIN_CAPACITY ?                 \
+                       DS_VECTOR_MIN_CAPACITY : v->capacity;                  \
+        while (capacity <= v->count) {                                        \
+                if (capacity > INT_MAX / 2) {                                 \
+                        capacity = INT_MAX;                                   \
+                        break;                                                \
+                }                                                             \
+                capacity *= 2;                                                \
+        }                                                                     \
+        return name##_reserve(v, capacity);                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_push(struct name##_t *v, T item) {                   \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        if (v->count >= v->capacity) {                                        \
+                int err = name##_grow_(v);                                    \
+                if (err) {                                                    \
+                        return err;                                           \
+                }                                                             \
+        }                                                                     \
+        v->data[v->count++] = item;                                           \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_pop(struct name##_t *v, T *item) {                   \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        if (v->count <= 0) {                                                  \
+                return DS_EMPTY_ERROR;                                        \
+        }                                                                     \
+        v->count--;                                                           \
+        if (item != NULL) {                                                   \
+                *item = v->data[v->count];                                    \
+        }                                                                     \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_get(struct name##_t *v, int index, T *item) {        \
+        if (v == NULL || item == NULL) {                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        if (index < 0 || index >= v->count) {                                 \
+                return DS_RANGE_ERROR;                                        \
+        }                                                                     \
+        *item = v->data[index];                                               \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_set(struct name##_t *v, int index, T item) {         \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        if (index < 0 || index >= v->count) {                                 \
+                return DS_RANGE_ERROR;                                        \
+        }                                                                     \
+        v->data[index] = item;                                                \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline T *name##_at(struct name##_t *v, int index) {                   \
+        return &v->data[index];                                               \
+}                                                                             \
+                                                                              \
+static inline T *name##_data(struct name##_t *v) {                            \
+        return v->data;                                                       \
+}                                                                             \
+                                                                              \
+static inline int name##_count(struct name##_t *v) {                          \
+        return v->count;                                                      \
+}                                                                             \
+                                                                              \
+static inline int name##_clear(struct name##_t *v) {                          \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        v->count = 0;                                                         \
+        return DS_NO_ERROR;                                                   \
+}                                                                             \
+                                                                              \
+static inline int name##_delete(struct name##_t *v) {                         \
+        if (v == NULL) {                                                      \
+                return DS_ARGUMENT_ERROR;                                     \
+        }                                                                     \
+        ds_free(v->allocator, v->data, (size_t)v->capacity * sizeof(T));      \
+        v->data = NULL;                                                       \
+        v->count = 0;                                                         \
+        v->capacity = 0;                                                      \
+        return DS_NO_ERROR;                                                   \
+}
+
+// string view
+//
+// a borrowed string, data is not necessarily null terminated
+// the memory is owned by someone else (a string builder for example)
+struct string_view_t {
+        const char *data;
+        int length;
+};
+
+// hash map
+//
+// hash map is an unordered map from fixed size keys to fixed size values
+// it uses open addressing with linear probing over one flat array of
+// slots, next to which one control byte per slot stores 7 bits of the
+// hash (or DS__HASH_MAP_EMPTY), so a probe checks 16 slots at once with
+// SSE2 (scalar fallback otherwise) before touching any key
+// removing a key shifts the following keys back, so there are no
+// tombstones and lookups never slow down after many removals
+// the capacity is a power of two and is doubled at 7/8 load
+//
+// hash and equal may be NULL, then keys are hashed and compared bytewise
+// equal returns non zero when both keys are the same
+struct hash_map_t {
+        unsigned char *ctrl;    // capacity + DS_HASH_MAP_GROUP - 1 bytes
+        char *slots;            // capacity slots of key and value
+        int  key_size;
+        int  value_size;
+        int  value_offset;      // offset of the value inside a slot
+        int  slot_size;
+        int  count;
+        int  capacity;
+        uint64_t (*hash)(const void *key, int size);
+        int (*equal)(const void *a, const void *b, int size);
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+#define DS_HASH_MAP_GROUP 16
+
+// hash and equal functions for hash_map_t
+// the _cstr variants are for keys of type const char *, they hash and
+// compare the strings pointed to instead of the pointers
+// the _string_view variants are for keys of type struct string_view_t
+uint64_t ds_hash_bytes(const void *key, int size);
+int      ds_equal_bytes(const void *a, const void *b, int size);
+uint64_t ds_hash_cstr(const void *key, int size);
+int      ds_equal_cstr(const void *a, const void *b, int size);
+uint64_t ds_hash_string_view(const void *key, int size);
+int      ds_equal_string_view(const void *a, const void *b, int size);
+
+int hash_map_init(struct hash_map_t *map, int key_size, int value_size,
+                  uint64_t (*hash)(const void *key, int size),
+                  int (*equal)(const void *a, const void *b, int size));
+int hash_map_init_alloc(struct hash_map_t *map, int key_size, 
+                        int value_size,
+                        uint64_t (*hash)(const void *key, int size),
+                        int (*equal)(const void *a, const void *b, int size),
+                        const struct ds_allocator_t *allocator);
+int hash_map_reserve(struct hash_map_t *map, int count);
+int hash_map_put(struct hash_map_t *map, const void *key, const void *value);
+int hash_map_get(struct hash_map_t *map, const void *key, void *value);
+void *hash_map_find(struct hash_map_t *map, const void *key);
+int hash_map_remove(struct hash_map_t *map, const void *key);
+int hash_map_next(struct hash_map_t *map, int *index, void **key, 
+                  void **value);
+int hash_map_clear(struct hash_map_t *map);
+int hash_map_delete(struct hash_map_t *map);
+int hash_map_stats(struct hash_map_t *map, struct ds_stats_t *stats);
+
+// b-tree map
+//
+// b-tree map is an ordered map from fixed size keys to fixed size values
+// it is a b+ tree: every key and value lives in a leaf, leaves are linked
+// both ways for range scans, inner nodes only hold separator keys
+// every node is one allocation of about DS_BTREE_NODE_SIZE bytes (a few
+// cache lines) with its keys stored contiguously, so a lookup touches a
+// handful of nodes and searches each one with a binary search
+// compare returns < 0, 0 or > 0 like the qsort comparator
+// iterators point at one entry, they are invalidated by put and remove
+#ifndef DS_BTREE_NODE_SIZE
+#define DS_BTREE_NODE_SIZE 256
+#endif
+
+struct ds__btree_node_t;
+
+struct btree_map_t {
+        struct ds__btree_node_t *root;  // NULL while the map is empty
+        int    key_size;
+        int    value_size;
+        int    leaf_capacity;
+        int    inner_capacity;
+        size_t values_offset;           // inside a leaf
+        size_t children_offset;         // inside an inner node
+        size_t leaf_size;
+        size_t inner_size;
+        int    count;
+        int (*compare)(const void *a, const void *b);
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+struct btree_iterator_t {
+        const struct btree_map_t *map;
+        struct ds__btree_node_t *leaf;  // NULL past either end
+        int index;
+};
+
+int btree_map_init(struct btree_map_t *map, int key_size, int value_size,
+                   int (*compare)(const void *a, const void *b));
+int btree_map_init_alloc(struct btree_map_t *map, int key_size, 
+                         int value_size,
+                         int (*compare)(const void *a, const void *b),
+                         const struct ds_allocator_t *allocator);
+int btree_map_bulk_load(struct btree_map_t *map, const void *keys,
+                        const void *values, int count);
+int btree_map_put(struct btree_map_t *map, const void *key, 
+                  const void *value);
+int btree_map_get(struct btree_map_t *map, const void *key, void *value);
+void *btree_map_find(struct btree_map_t *map, const void *key);
+int btree_map_remove(struct btree_map_t *map, const void *key);
+int btree_map_first(const struct btree_map_t *map, 
+                    struct btree_iterator_t *iterator, void **key, 
+                    void **value);
+int btree_map_last(const struct btree_map_t *map, 
+                   struct btree_iterator_t *iterator, void **key, 
+                   void **value);
+int btree_map_lower_bound(const struct btree_map_t *map, const void *key,
+                          struct btree_iterator_t *iterator, 
+                          void **found_key, void **value);
+int btree_map_next(struct btree_iterator_t *iterator, void **key, 
+                   void **value);
+int btree_map_prev(struct btree_iterator_t *iterator, void **key, 
+                   void **value);
+int btree_map_clear(struct btree_map_t *map);
+int btree_map_delete(struct btree_map_t *map);
+int btree_map_stats(struct btree_map_t *map, struct ds_stats_t *stats);
 
 // string builder
 //
 // string builder helps you to build strings
-// it uses the vector type to grow dynamically
+// characters are kept in one growable buffer that doubles when full,
+// appends copy whole strings at once with memcpy
+// short strings (up to DS_STRING_BUILDER_INLINE - 1 characters) are kept
+// inside the string builder itself and never touch the heap, chars is
+// NULL while the inline buffer is used
+#ifndef DS_STRING_BUILDER_INLINE
+#define DS_STRING_BUILDER_INLINE 48
+#endif
+
 struct string_builder_t {
-        struct vector_t chars;
+        char *chars;    // heap storage, NULL while inline_chars is used
+        int  count;
+        int  capacity;
+        char inline_chars[DS_STRING_BUILDER_INLINE];
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
 };
 
 int string_builder_init(struct string_builder_t *sb);
+int string_builder_init_alloc(struct string_builder_t *sb,
+                              const struct ds_allocator_t *allocator);
 int string_builder_appendf(struct string_builder_t *sb, const char *format, 
                           ...);
 int string_builder_appendn(struct string_builder_t *sb, const char *str,
@@ -56,10 +699,293 @@ int string_builder_appendn(struct string_builder_t *sb, const char *str,
 int string_builder_append(struct string_builder_t *sb, const char *str);
 int string_builder_appendc(struct string_builder_t *sb, char ch);
 int string_builder_appendcn(struct string_builder_t *sb, char ch, int len);
+// number appends format straight into the string builder without printf
+int string_builder_append_int(struct string_builder_t *sb, int value);
+int string_builder_append_uint(struct string_builder_t *sb, 
+                               unsigned int value);
+int string_builder_append_i64(struct string_builder_t *sb, int64_t value);
+int string_builder_append_u64(struct string_builder_t *sb, uint64_t value);
+int string_builder_append_hex(struct string_builder_t *sb, uint64_t value);
+int string_builder_append_double(struct string_builder_t *sb, 
+                                 double value);
 int string_builder_get(struct string_builder_t *sb, int index, char *ch);
 int string_builder_set(struct string_builder_t *sb, int index, char ch);
+// the built string is allocated with the allocator of the string builder
+// free it with ds_free(sb->allocator, str, strlen(str) + 1)
 int string_builder_build(struct string_builder_t *sb, char **str);
+// view and cstr borrow the storage of the string builder, they are valid
+// until the string builder is changed or moved
+int string_builder_view(struct string_builder_t *sb, 
+                        struct string_view_t *view);
+int string_builder_cstr(struct string_builder_t *sb, const char **str);
+// steal hands the storage over to the caller and resets the string
+// builder, free it with ds_free(sb->allocator, str, length + 1)
+int string_builder_steal(struct string_builder_t *sb, char **str, 
+                         int *length);
+// search, count, replace and split scan with sse2 or avx2 when available
+int string_builder_find(struct string_builder_t *sb, const char *needle,
+                        int start, int *index);
+int string_builder_find_char(struct string_builder_t *sb, char ch, 
+                             int start, int *index);
+int string_builder_count_char(struct string_builder_t *sb, char ch, 
+                              int *count);
+int string_builder_replace(struct string_builder_t *sb, const char *from,
+                           const char *to, int *replaced);
+int string_builder_split(struct string_builder_t *sb, char delimiter,
+                         struct vector_t *parts);
 int string_builder_delete(struct string_builder_t *sb);
+int string_builder_stats(struct string_builder_t *sb, 
+                         struct ds_stats_t *stats);
+
+// rope builder
+//
+// rope builder builds very large strings out of a list of fixed size
+// segments, appending never moves or reallocates what is already there
+// when a file or file descriptor is set, the buffered segments are
+// written out (with writev for descriptors) as soon as flush_threshold
+// bytes are buffered, and are then reused, so memory stays bounded no
+// matter how much is appended
+// nothing is flushed on delete, call rope_builder_flush first
+struct ds__rope_segment_t;
+
+struct rope_builder_t {
+        struct ds__rope_segment_t *head;        // oldest buffered segment
+        struct ds__rope_segment_t *tail;        // segment being filled
+        struct ds__rope_segment_t *spare;       // flushed, ready for reuse
+        int  segment_size;
+        long long length;                       // bytes appended so far
+        long long buffered;                     // bytes not flushed yet
+        long long flush_threshold;              // 0 means never flush
+        FILE *file;
+        int  fd;                                // -1 when not set
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+#ifndef DS_ROPE_BUILDER_SEGMENT
+#define DS_ROPE_BUILDER_SEGMENT (64 * 1024)
+#endif
+
+int rope_builder_init(struct rope_builder_t *rope, int segment_size);
+int rope_builder_init_alloc(struct rope_builder_t *rope, int segment_size,
+                            const struct ds_allocator_t *allocator);
+int rope_builder_set_fd(struct rope_builder_t *rope, int fd, 
+                        long long flush_threshold);
+int rope_builder_set_file(struct rope_builder_t *rope, FILE *file,
+                          long long flush_threshold);
+int rope_builder_write(struct rope_builder_t *rope, const void *data, 
+                       long long len);
+int rope_builder_append(struct rope_builder_t *rope, const char *str);
+int rope_builder_appendc(struct rope_builder_t *rope, char ch);
+int rope_builder_appendf(struct rope_builder_t *rope, const char *format,
+                         ...);
+int rope_builder_flush(struct rope_builder_t *rope);
+// the built string is allocated with the allocator of the rope builder
+// and holds only what was not flushed yet
+int rope_builder_build(struct rope_builder_t *rope, char **str, 
+                       long long *length);
+int rope_builder_delete(struct rope_builder_t *rope);
+int rope_builder_stats(struct rope_builder_t *rope, 
+                       struct ds_stats_t *stats);
+
+// string interner
+//
+// string interner keeps one copy of every distinct string and gives it a
+// small integer id, ids count up from 0 in the order strings are first
+// seen, so two interned strings are equal exactly when their ids are
+// the bytes are packed back to back in an arena (with a NUL after each
+// string) and never move, the views handed out stay valid until
+// string_interner_delete frees everything at once
+// string_interner_init_alloc gives the allocator to the id table and the
+// hash map, the arena blocks always come from malloc
+struct string_interner_t {
+        struct ds_arena_t arena;        // the string bytes
+        struct vector_t   strings;      // id -> struct string_view_t
+        struct hash_map_t ids;          // struct string_view_t -> id
+};
+
+int string_interner_init(struct string_interner_t *interner);
+int string_interner_init_alloc(struct string_interner_t *interner,
+                               const struct ds_allocator_t *allocator);
+int string_interner_intern(struct string_interner_t *interner, 
+                           const char *str, int *id);
+int string_interner_internn(struct string_interner_t *interner, 
+                            const char *str, int length, int *id);
+int string_interner_lookup(struct string_interner_t *interner, 
+                           const char *str, int length, int *id);
+int string_interner_get(struct string_interner_t *interner, int id,
+                        struct string_view_t *view);
+int string_interner_count(struct string_interner_t *interner, int *count);
+int string_interner_delete(struct string_interner_t *interner);
+
+#ifdef DS__HAS_ATOMICS
+
+// queues
+//
+// bounded ring buffer queues for passing fixed size items between threads
+// spsc_queue_t is wait free for one producer and one consumer thread
+// mpsc_queue_t is lock free for any number of producer threads and one
+// consumer thread, every slot carries a sequence number so producers can
+// claim slots with a single compare and swap
+// the capacity is rounded up to a power of two, the hot counters of each
+// side are kept on their own cache line (so heap allocated queues should
+// use aligned_alloc with DS_CACHE_LINE)
+// push returns DS_FULL_ERROR when there is no room, pop returns
+// DS_EMPTY_ERROR when there is nothing, the _many variants move as many
+// items as possible and report how many
+#ifndef DS_CACHE_LINE
+#define DS_CACHE_LINE 64
+#endif
+
+struct spsc_queue_t {
+        // written by the consumer
+        _Alignas(DS_CACHE_LINE) atomic_size_t head;
+        size_t cached_tail;     // last tail seen by the consumer
+
+        // written by the producer
+        _Alignas(DS_CACHE_LINE) atomic_size_t tail;
+        size_t cached_head;     // last head seen by the producer
+
+        // never written after init
+        _Alignas(DS_CACHE_LINE) char *items;
+        size_t mask;
+        int  item_size;
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int spsc_queue_init(struct spsc_queue_t *queue, int capacity, 
+                    int item_size);
+int spsc_queue_init_alloc(struct spsc_queue_t *queue, int capacity,
+                          int item_size, 
+                          const struct ds_allocator_t *allocator);
+int spsc_queue_push(struct spsc_queue_t *queue, const void *item, int size);
+int spsc_queue_pop(struct spsc_queue_t *queue, void *item, int size);
+int spsc_queue_push_many(struct spsc_queue_t *queue, const void *items,
+                         int count, int size, int *pushed);
+int spsc_queue_pop_many(struct spsc_queue_t *queue, void *items, int count,
+                        int size, int *popped);
+int spsc_queue_delete(struct spsc_queue_t *queue);
+int spsc_queue_stats(struct spsc_queue_t *queue, struct ds_stats_t *stats);
+
+struct mpsc_queue_t {
+        // shared by the producers
+        _Alignas(DS_CACHE_LINE) atomic_size_t tail;
+
+        // owned by the consumer
+        _Alignas(DS_CACHE_LINE) size_t head;
+
+        // never written after init
+        _Alignas(DS_CACHE_LINE) char *slots;    // sequence then item
+        size_t mask;
+        int  item_size;
+        int  slot_size;
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int mpsc_queue_init(struct mpsc_queue_t *queue, int capacity, 
+                    int item_size);
+int mpsc_queue_init_alloc(struct mpsc_queue_t *queue, int capacity,
+                          int item_size, 
+                          const struct ds_allocator_t *allocator);
+int mpsc_queue_push(struct mpsc_queue_t *queue, const void *item, int size);
+int mpsc_queue_pop(struct mpsc_queue_t *queue, void *item, int size);
+int mpsc_queue_push_many(struct mpsc_queue_t *queue, const void *items,
+                         int count, int size, int *pushed);
+int mpsc_queue_pop_many(struct mpsc_queue_t *queue, void *items, int count,
+                        int size, int *popped);
+int mpsc_queue_delete(struct mpsc_queue_t *queue);
+int mpsc_queue_stats(struct mpsc_queue_t *queue, struct ds_stats_t *stats);
+
+// segmented vector
+//
+// append only vector that can be shared between threads
+// items are stored in blocks of DS_SEGMENTED_VECTOR_FIRST, 2x, 4x, ...
+// items, a block never moves once installed, so pointers to items stay
+// valid until the vector is deleted
+// appends reserve an index with one atomic add, the thread that first
+// needs a block installs it with a compare and swap
+// reads take no lock, an item may only be read by a thread that knows its
+// append finished (it got the index from the appender, joined it, ...)
+// the allocator has to be thread safe when more than one thread appends,
+// and like every DS_STATS counter the stats of the vector are not updated
+// atomically
+// an append that fails with DS_MALLOC_ERROR still used up its index: the
+// count includes it but nothing was written there, reading it gives
+// DS_RANGE_ERROR while its block is missing and unspecified bytes once
+// another append installed the block
+// DS_SEGMENTED_VECTOR_FIRST can be overridden but has to be a power of
+// two, the block of an index is found from the highest bit set in it
+#ifndef DS_SEGMENTED_VECTOR_FIRST
+#define DS_SEGMENTED_VECTOR_FIRST 8
+#endif
+
+#if (DS_SEGMENTED_VECTOR_FIRST) <= 0 || \
+    ((DS_SEGMENTED_VECTOR_FIRST) & ((DS_SEGMENTED_VECTOR_FIRST) - 1)) != 0
+#error "DS_SEGMENTED_VECTOR_FIRST must be a power of two"
+#endif
+
+#define DS__SEGMENTED_VECTOR_BLOCKS 32
+
+struct segmented_vector_t {
+        _Atomic(char *) blocks[DS__SEGMENTED_VECTOR_BLOCKS];
+        atomic_int count;       // reserved items
+        int item_size;
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int segmented_vector_init(struct segmented_vector_t *vector, int item_size);
+int segmented_vector_init_alloc(struct segmented_vector_t *vector, 
+                                int item_size,
+                                const struct ds_allocator_t *allocator);
+int segmented_vector_append(struct segmented_vector_t *vector, 
+                            const void *item, int size, int *index);
+int segmented_vector_get(struct segmented_vector_t *vector, int index, 
+                         void *item, int size);
+int segmented_vector_at(struct segmented_vector_t *vector, int index, 
+                        void **item);
+int segmented_vector_count(struct segmented_vector_t *vector, int *count);
+int segmented_vector_delete(struct segmented_vector_t *vector);
+int segmented_vector_stats(struct segmented_vector_t *vector, 
+                           struct ds_stats_t *stats);
+
+#endif // DS__HAS_ATOMICS
+
+// bitset
+//
+// bitset is a growable array of bits packed into 64 bit words
+// setting a bit past the end grows the bitset, testing one reads 0
+// the bulk operations work a word at a time (four with avx2), count and
+// rank use the popcnt instruction or an avx2 kernel when the cpu has them
+// and_with, or_with, xor_with and andnot_with change dst in place, dst
+// grows to the size of src where the result needs it
+struct bitset_t {
+        uint64_t *words;
+        size_t   count;         // bits
+        size_t   capacity;      // words
+        const struct ds_allocator_t *allocator;
+        DS__STATS_MEMBER
+};
+
+int bitset_init(struct bitset_t *bitset);
+int bitset_init_alloc(struct bitset_t *bitset, 
+                      const struct ds_allocator_t *allocator);
+int bitset_resize(struct bitset_t *bitset, size_t count);
+int bitset_set(struct bitset_t *bitset, size_t bit);
+int bitset_clear(struct bitset_t *bitset, size_t bit);
+int bitset_test(struct bitset_t *bitset, size_t bit, int *value);
+int bitset_clear_all(struct bitset_t *bitset);
+int bitset_count(struct bitset_t *bitset, size_t *count);
+int bitset_rank(struct bitset_t *bitset, size_t bit, size_t *rank);
+int bitset_find_next_set(struct bitset_t *bitset, size_t from, size_t *bit);
+int bitset_and_with(struct bitset_t *dst, const struct bitset_t *src);
+int bitset_or_with(struct bitset_t *dst, const struct bitset_t *src);
+int bitset_xor_with(struct bitset_t *dst, const struct bitset_t *src);
+int bitset_andnot_with(struct bitset_t *dst, const struct bitset_t *src);
+int bitset_delete(struct bitset_t *bitset);
+int bitset_stats(struct bitset_t *bitset, struct ds_stats_t *stats);
 
 // argument parser
 //
@@ -91,10 +1017,19 @@ struct ap_parser_t {
         const char *version;
         const char *description;
         struct vector_t arguments;
+        const struct ds_allocator_t *allocator;
+
+        // names to arguments, built by ap_parser_parse
+        struct hash_map_t index;
+        int indexed;            // number of arguments in the index
 };
 
 int ap_parser_init(struct ap_parser_t *parser, const char *program_name, 
                    const char *version, const char *description);
+int ap_parser_init_alloc(struct ap_parser_t *parser, 
+                         const char *program_name, const char *version, 
+                         const char *description,
+                         const struct ds_allocator_t *allocator);
 int ap_parser_add_argument(struct ap_parser_t *parser, 
                            struct ap_argument_t *argument);
 int ap_parser_parse(struct ap_parser_t *parser, int argc, const char **argv);
@@ -110,6 +1045,16 @@ int ap_parser_delete(struct ap_parser_t *parser);
 
 #ifdef DS_IMPLEMENTATION
 
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifndef DS_NO_THREADS
+#include <pthread.h>
+#endif
+
 void ds_print_error(enum ds_error_enum err) {
         const char *error_msgs[DS_NUM_OF_ERRORS] = {
                 "no error",
@@ -120,6 +1065,11 @@ void ds_print_error(enum ds_error_enum err) {
                 "out of range",
                 "something more was expected",
                 "something went wrong",
+                "not found",
+                "input/output error",
+                "no room",
+                "read only",
+                "bad file format",
         };
         if (err >= DS_NUM_OF_ERRORS) {
                 printf("invalid error no\n");
@@ -128,321 +1078,7590 @@ void ds_print_error(enum ds_error_enum err) {
         printf("%s\n", error_msgs[err]);
 }
 
-// initialize the vector
+// allocate size bytes with the given allocator
 //
-// keeps count, capacity as 0
-// keeps items, sizes as NULL
-// returns 0 if no error
-int vector_init(struct vector_t *vector) {
-        if (vector == NULL) {
-                return DS_ARGUMENT_ERROR;
+// uses malloc when allocator is NULL
+// returns NULL on failure
+void *ds_alloc(const struct ds_allocator_t *allocator, size_t size) {
+        if (allocator == NULL) {
+                return malloc(size);
         }
-        vector->items = NULL;
-        vector->sizes = NULL;
-        vector->count = 0;
-        vector->capacity = 0;
-        return DS_NO_ERROR;
+        return allocator->alloc_fn(allocator->context, size);
 }
 
-// append an item to the vector
+// resize a block allocated with the given allocator
 //
-// returns 0 if no error
-// allocates 8 value at a time if max capacity is reached
-int vector_append(struct vector_t *vector, void *item, int size) {
-        if (vector == NULL || item == NULL) {
-                return DS_ARGUMENT_ERROR;
+// uses realloc when allocator is NULL
+// returns NULL on failure, the old block is left untouched then
+void *ds_realloc(const struct ds_allocator_t *allocator, void *ptr,
+                 size_t old_size, size_t new_size) {
+        if (allocator == NULL) {
+                return realloc(ptr, new_size);
         }
+        return allocator->realloc_fn(allocator->context, ptr, old_size, 
+                                     new_size);
+}
 
-        if (vector->count >= vector->capacity) {
-                int new_capacity = vector->capacity + 8;
-                void **temp_items = malloc(new_capacity * sizeof(void *));
-                int   *temp_sizes = malloc(new_capacity * sizeof(int));
-                
-                if (temp_items == NULL || temp_sizes == NULL) {
-                        return DS_MALLOC_ERROR;
-                }
+// free a block allocated with the given allocator
+//
+// uses free when allocator is NULL
+void ds_free(const struct ds_allocator_t *allocator, void *ptr, 
+             size_t size) {
+        if (allocator == NULL) {
+                free(ptr);
+                return;
+        }
+        allocator->free_fn(allocator->context, ptr, size);
+}
 
-                for (int i = 0; i < vector->count; i++) {
-                        temp_items[i] = vector->items[i];
-                        temp_sizes[i] = vector->sizes[i];
-                }
+// the containers allocate through DS__ALLOC, DS__REALLOC and DS__FREE and
+// count through DS__STATS_ADD, c is the container
+// without DS_STATS they are plain calls and the counting disappears
+#ifdef DS_STATS
 
-                free(vector->items);
-                free(vector->sizes);
+static struct ds_stats_t ds__stats_global;
 
-                vector->items = temp_items;
-                vector->sizes = temp_sizes;
-                vector->capacity = new_capacity;
+static void ds__stats_count_alloc(struct ds_stats_t *stats, size_t old_size,
+                                  size_t new_size) {
+        struct ds_stats_t *all[2] = { &ds__stats_global, stats };
+        for (int i = 0; i < 2; i++) {
+                all[i]->mallocs++;
+                all[i]->bytes_allocated += new_size;
+                all[i]->live_bytes += (long long)new_size - 
+                                      (long long)old_size;
+                if (all[i]->live_bytes > all[i]->high_water) {
+                        all[i]->high_water = all[i]->live_bytes;
+                }
         }
+}
 
-        char *temp = malloc(size * sizeof(char));
-        if (temp == NULL) {
-                return DS_MALLOC_ERROR;
+static void *ds__stats_alloc(const struct ds_allocator_t *allocator,
+                             struct ds_stats_t *stats, size_t size) {
+        void *ptr = ds_alloc(allocator, size);
+        if (ptr != NULL) {
+                ds__stats_count_alloc(stats, 0, size);
         }
-        memcpy(temp, item, size);
+        return ptr;
+}
 
-        vector->sizes[vector->count] = size;
-        vector->items[vector->count] = temp;
-        vector->count++;
+static void *ds__stats_realloc(const struct ds_allocator_t *allocator,
+                               struct ds_stats_t *stats, void *ptr,
+                               size_t old_size, size_t new_size) {
+        void *temp = ds_realloc(allocator, ptr, old_size, new_size);
+        if (temp != NULL) {
+                ds__stats_count_alloc(stats, ptr ? old_size : 0, new_size);
+        }
+        return temp;
+}
 
-        return DS_NO_ERROR;
+static void ds__stats_free(const struct ds_allocator_t *allocator,
+                           struct ds_stats_t *stats, void *ptr, 
+                           size_t size) {
+        if (ptr != NULL) {
+                ds__stats_global.frees++;
+                ds__stats_global.live_bytes -= size;
+                stats->frees++;
+                stats->live_bytes -= size;
+        }
+        ds_free(allocator, ptr, size);
 }
 
-// get the top value of the vector
+#define DS__ALLOC(c, size) \
+        ds__stats_alloc((c)->allocator, &(c)->stats, (size))
+#define DS__REALLOC(c, ptr, old_size, new_size) \
+        ds__stats_realloc((c)->allocator, &(c)->stats, (ptr), (old_size), \
+                          (new_size))
+#define DS__FREE(c, ptr, size) \
+        ds__stats_free((c)->allocator, &(c)->stats, (ptr), (size))
+#define DS__STATS_ADD(c, field, n) \
+        do { \
+                ds__stats_global.field += (n); \
+                (c)->stats.field += (n); \
+        } while (0)
+#define DS__STATS_INIT(c) memset(&(c)->stats, 0, sizeof((c)->stats))
+
+#else
+
+#define DS__ALLOC(c, size) ds_alloc((c)->allocator, (size))
+#define DS__REALLOC(c, ptr, old_size, new_size) \
+        ds_realloc((c)->allocator, (ptr), (old_size), (new_size))
+#define DS__FREE(c, ptr, size) ds_free((c)->allocator, (ptr), (size))
+#define DS__STATS_ADD(c, field, n) ((void)0)
+#define DS__STATS_INIT(c) ((void)0)
+
+#endif // DS_STATS
+
+// copy the global counters into stats
 //
 // returns 0 if no error
-int vector_top(struct vector_t *vector, void *item, int size) {
-        if (vector == NULL || item == NULL) {
+int ds_stats_snapshot(struct ds_stats_t *stats) {
+        if (stats == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
-        if (vector->count <= 0) {
-                return DS_EMPTY_ERROR;
-        }
-        if (vector->sizes[vector->count - 1] != size) {
-                return DS_SIZE_ERROR;
-        }
-
-        memcpy(item, vector->items[vector->count - 1], size);
+#ifdef DS_STATS
+        *stats = ds__stats_global;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
 
+// reset the global counters
+//
+// live_bytes is kept since that memory is still allocated
+// returns 0 if no error
+int ds_stats_reset(void) {
+#ifdef DS_STATS
+        long long live_bytes = ds__stats_global.live_bytes;
+        memset(&ds__stats_global, 0, sizeof(ds__stats_global));
+        ds__stats_global.live_bytes = live_bytes;
+        ds__stats_global.high_water = live_bytes;
+#endif
         return DS_NO_ERROR;
 }
 
-// removes the last value of the vector
+// print the counters as one line of key=value pairs
 //
+// stats NULL means the global counters
 // returns 0 if no error
-int vector_pop(struct vector_t *vector) {
-        if (vector == NULL) {
+int ds_stats_dump(FILE *out, const char *label, 
+                  const struct ds_stats_t *stats) {
+        if (out == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
-        if (vector->count <= 0) {
-                return DS_EMPTY_ERROR;
-        }
-        
-        free(vector->items[vector->count - 1]);
-        vector->count--;
 
+        struct ds_stats_t global;
+        if (stats == NULL) {
+                ds_stats_snapshot(&global);
+                stats = &global;
+        }
+        fprintf(out, "%s: mallocs=%lld frees=%lld bytes_allocated=%lld "
+                "live_bytes=%lld high_water=%lld grows=%lld "
+                "memcpy_bytes=%lld\n", label ? label : "ds", 
+                stats->mallocs, stats->frees, stats->bytes_allocated,
+                stats->live_bytes, stats->high_water, stats->grows,
+                stats->memcpy_bytes);
         return DS_NO_ERROR;
 }
 
-// get the value at a specific index
-//
-// returns 0 if no error
-int vector_get(struct vector_t *vector, int index, void *item, int size) {
-        if (vector == NULL || item == NULL) {
-                return DS_ARGUMENT_ERROR;
+// a block of the arena, the memory handed out follows the header
+struct ds_arena_block_t {
+        struct ds_arena_block_t *prev;
+        size_t size;
+        size_t used;
+};
+
+#define DS__ARENA_ALIGN 16
+#define DS__ARENA_HEADER \
+        ((sizeof(struct ds_arena_block_t) + DS__ARENA_ALIGN - 1) & \
+         ~(size_t)(DS__ARENA_ALIGN - 1))
+
+static char *ds__arena_block_data(struct ds_arena_block_t *block) {
+        return (char *)block + DS__ARENA_HEADER;
+}
+
+static void *ds__arena_alloc_fn(void *context, size_t size) {
+        return ds_arena_alloc(context, size);
+}
+
+// grows the block in place when it is the latest allocation of the arena
+static void *ds__arena_realloc_fn(void *context, void *ptr, size_t old_size,
+                                  size_t new_size) {
+        struct ds_arena_t *arena = context;
+        struct ds_arena_block_t *head = arena->head;
+        if (ptr == NULL) {
+                return ds_arena_alloc(arena, new_size);
         }
-        if (index < 0 || index >= vector->count) {
-                return DS_RANGE_ERROR;
+
+        size_t aligned_old = (old_size + DS__ARENA_ALIGN - 1) & 
+                             ~(size_t)(DS__ARENA_ALIGN - 1);
+        size_t aligned_new = (new_size + DS__ARENA_ALIGN - 1) & 
+                             ~(size_t)(DS__ARENA_ALIGN - 1);
+        if (head != NULL && 
+            (char *)ptr + aligned_old == ds__arena_block_data(head) + 
+                                         head->used &&
+            aligned_new >= aligned_old &&
+            head->used - aligned_old + aligned_new <= head->size) {
+                head->used = head->used - aligned_old + aligned_new;
+                return ptr;
         }
-        if (vector->sizes[vector->count - 1] != size) {
-                return DS_SIZE_ERROR;
+        if (new_size <= old_size) {
+                return ptr;
         }
 
-        memcpy(item, vector->items[index], size);
+        void *temp = ds_arena_alloc(arena, new_size);
+        if (temp == NULL) {
+                return NULL;
+        }
+        memcpy(temp, ptr, old_size);
+        return temp;
+}
 
-        return DS_NO_ERROR;
+// memory is only given back when it is the latest allocation of the arena
+static void ds__arena_free_fn(void *context, void *ptr, size_t size) {
+        struct ds_arena_t *arena = context;
+        struct ds_arena_block_t *head = arena->head;
+        size_t aligned = (size + DS__ARENA_ALIGN - 1) & 
+                         ~(size_t)(DS__ARENA_ALIGN - 1);
+        if (ptr != NULL && head != NULL && 
+            (char *)ptr + aligned == ds__arena_block_data(head) + 
+                                     head->used) {
+                head->used -= aligned;
+        }
 }
 
-// set the value at a specific index
+// initialize the arena
 //
+// block_size is the size of every new block, 0 means DS_ARENA_BLOCK_SIZE
+// no memory is allocated until the first allocation
 // returns 0 if no error
-int vector_set(struct vector_t *vector, int index, void *item, int size) {
-        if (vector == NULL || item == NULL) {
+int ds_arena_init(struct ds_arena_t *arena, size_t block_size) {
+        if (arena == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
-        if (index < 0 || index >= vector->count) {
-                return DS_RANGE_ERROR;
-        }
 
-        free(vector->items[index]);
-        char *temp = malloc(size * sizeof(char));
-        if (temp == NULL) {
-                return DS_MALLOC_ERROR;
-        }
+        arena->head = NULL;
+        arena->block_size = block_size ? block_size : DS_ARENA_BLOCK_SIZE;
+        arena->allocator.alloc_fn = ds__arena_alloc_fn;
+        arena->allocator.realloc_fn = ds__arena_realloc_fn;
+        arena->allocator.free_fn = ds__arena_free_fn;
+        arena->allocator.context = arena;
+        return DS_NO_ERROR;
+}
 
-        vector->items[index] = temp;
-        vector->sizes[index] = size;
-        memcpy(vector->items[index], item, size);
+// take size bytes aligned to align from the head block, or from a new
+// block when they do not fit
+static void *ds__arena_take(struct ds_arena_t *arena, size_t size, 
+                            size_t align) {
+        struct ds_arena_block_t *head = arena->head;
+        size_t start = 0;
+        if (head != NULL) {
+                start = (head->used + align - 1) & ~(align - 1);
+        }
+        if (head == NULL || start > head->size || 
+            head->size - start < size) {
+                size_t block_size = arena->block_size;
+                if (block_size < size) {
+                        block_size = size;
+                }
+                if (block_size > (size_t)-1 - DS__ARENA_HEADER) {
+                        return NULL;
+                }
+                head = malloc(DS__ARENA_HEADER + block_size);
+                if (head == NULL) {
+                        return NULL;
+                }
+                head->prev = arena->head;
+                head->size = block_size;
+                head->used = 0;
+                arena->head = head;
+                start = 0;
+        }
 
-        return DS_NO_ERROR;
+        head->used = start + size;
+        return ds__arena_block_data(head) + start;
 }
 
-// delete the vector
+// allocate size bytes from the arena
 //
-// frees the item space that was allocated
-// set all the fields to zero
-int vector_delete(struct vector_t *vector) {
-        if (vector == NULL) {
-                return DS_ARGUMENT_ERROR;
+// the memory is aligned to 16 bytes
+// a new block is started when the current one is full
+// returns NULL on failure
+void *ds_arena_alloc(struct ds_arena_t *arena, size_t size) {
+        if (arena == NULL) {
+                return NULL;
         }
 
-        for (int i = 0; i < vector->count; i++) {
-                free(vector->items[i]);
+        size_t aligned = (size + DS__ARENA_ALIGN - 1) & 
+                         ~(size_t)(DS__ARENA_ALIGN - 1);
+        if (aligned < size) {
+                return NULL;
         }
-        free(vector->items);
-        free(vector->sizes);
-
-        vector->count = 0;
-        vector->capacity = 0;
-        vector->items = NULL;
-        vector->sizes = NULL;
+        return ds__arena_take(arena, aligned, DS__ARENA_ALIGN);
+}
 
-        return DS_NO_ERROR;
+// allocate size bytes from the arena without any alignment
+//
+// consecutive calls hand out memory back to back, which suits strings
+// and other byte data
+// returns NULL on failure
+void *ds_arena_alloc_bytes(struct ds_arena_t *arena, size_t size) {
+        if (arena == NULL) {
+                return NULL;
+        }
+        return ds__arena_take(arena, size, 1);
 }
 
-// initialize a string builder
+// remember the current position of the arena
 //
-// it uses vector under the hood
-int string_builder_init(struct string_builder_t *sb) {
-        if (sb == NULL) {
+// returns 0 if no error
+int ds_arena_mark(struct ds_arena_t *arena, struct ds_arena_mark_t *mark) {
+        if (arena == NULL || mark == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
 
-        return vector_init(&sb->chars);
+        mark->block = arena->head;
+        mark->used = arena->head ? arena->head->used : 0;
+        return DS_NO_ERROR;
 }
 
-// append a formated string like printf
+// release everything allocated after the mark
 //
-// uses vsnprintf to calculate the final string
-// and then allocate the required memory
-// and append the final string to the string_builder
-// returns 0 if nothing went wrong while appending the string
-int string_builder_appendf(struct string_builder_t *sb, const char *format,
-                          ...) {
-        if (sb == NULL) {
+// a NULL mark (or a mark taken before the first allocation) releases
+// everything, the first block is kept and reused so a reset and alloc
+// loop does not go back to malloc every time
+// resetting to a mark invalidates every mark taken after it, their
+// blocks may be gone
+// returns 0 if no error
+// returns DS_ARGUMENT_ERROR for a mark whose block was already freed, the
+// arena is then left as it is
+int ds_arena_reset(struct ds_arena_t *arena, 
+                   const struct ds_arena_mark_t *mark) {
+        if (arena == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
 
-        va_list args;
-        va_start(args, format);
-        int needed = vsnprintf(NULL, 0, format, args);
-        va_end(args);
-
-        char *buffer = malloc((needed + 1) * sizeof(char));
-        if (buffer == NULL) {
-                return DS_MALLOC_ERROR;
+        struct ds_arena_block_t *block = mark ? mark->block : NULL;
+        if (block == NULL) {
+                while (arena->head != NULL && arena->head->prev != NULL) {
+                        struct ds_arena_block_t *prev = arena->head->prev;
+                        free(arena->head);
+                        arena->head = prev;
+                }
+                if (arena->head != NULL) {
+                        arena->head->used = 0;
+                }
+                return DS_NO_ERROR;
+        }
+
+        // a stale mark (its block freed by an earlier reset) changes
+        // nothing, so look for the block before freeing any
+        struct ds_arena_block_t *at = arena->head;
+        while (at != NULL && at != block) {
+                at = at->prev;
+        }
+        if (at == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        while (arena->head != block) {
+                struct ds_arena_block_t *prev = arena->head->prev;
+                free(arena->head);
+                arena->head = prev;
+        }
+        arena->head->used = mark->used;
+        return DS_NO_ERROR;
+}
+
+// delete the arena
+//
+// frees all the blocks at once
+int ds_arena_delete(struct ds_arena_t *arena) {
+        if (arena == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        while (arena->head != NULL) {
+                struct ds_arena_block_t *prev = arena->head->prev;
+                free(arena->head);
+                arena->head = prev;
+        }
+        return DS_NO_ERROR;
+}
+
+// initialize the vector
+//
+// keeps count, capacity as 0
+// keeps items, sizes as NULL
+// returns 0 if no error
+int vector_init(struct vector_t *vector) {
+        return vector_init_alloc(vector, 0, NULL);
+}
+
+// initialize the vector with a fixed item size
+//
+// every item of the vector must be exactly stride bytes
+// items are stored inline in one contiguous buffer
+// returns 0 if no error
+int vector_init_fixed(struct vector_t *vector, int stride) {
+        if (stride <= 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        return vector_init_alloc(vector, stride, NULL);
+}
+
+// initialize the vector with a custom allocator
+//
+// stride 0 means variable sized items like vector_init
+// stride > 0 means fixed sized items like vector_init_fixed
+// allocator NULL means malloc and free
+// returns 0 if no error
+int vector_init_alloc(struct vector_t *vector, int stride,
+                      const struct ds_allocator_t *allocator) {
+        if (vector == NULL || stride < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        vector->items = NULL;
+        vector->sizes = NULL;
+        vector->data = NULL;
+        vector->stride = stride;
+        vector->count = 0;
+        vector->capacity = 0;
+        vector->growth_factor = DS_VECTOR_GROWTH_FACTOR;
+        vector->allocator = allocator;
+        vector->map = NULL;
+        vector->map_size = 0;
+        vector->read_only = 0;
+        DS__STATS_INIT(vector);
+        return DS_NO_ERROR;
+}
+
+// get the address of the item at a given index
+//
+// index is not checked, caller must make sure it is in range
+static void *ds__vector_item(struct vector_t *vector, int index) {
+        if (vector->stride > 0) {
+                return vector->data + (size_t)index * vector->stride;
+        }
+        return vector->items[index];
+}
+
+// get the size of the item at a given index
+//
+// index is not checked, caller must make sure it is in range
+static int ds__vector_item_size(struct vector_t *vector, int index) {
+        if (vector->stride > 0) {
+                return vector->stride;
+        }
+        return vector->sizes[index];
+}
+
+// set the growth factor of the vector
+//
+// the capacity is multiplied by factor whenever the vector is full
+// factor must be greater than 1
+// returns 0 if no error
+int vector_set_growth_factor(struct vector_t *vector, double factor) {
+        if (vector == NULL || !(factor > 1.0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+        vector->growth_factor = factor;
+        return DS_NO_ERROR;
+}
+
+// mapped read only vectors can not be written
+//
+// returns 0 if the items can be written
+static int ds__vector_check_writable(struct vector_t *vector) {
+        if (vector->read_only) {
+                return DS_READ_ONLY_ERROR;
+        }
+        return DS_NO_ERROR;
+}
+
+// move a mapped vector to the heap, or just unmap it for capacity 0
+//
+// returns 0 if no error
+static int ds__vector_unmap(struct vector_t *vector, int new_capacity) {
+        char *data = NULL;
+        if (new_capacity > 0) {
+                int err = ds__vector_check_writable(vector);
+                if (err) {
+                        return err;
+                }
+                data = DS__ALLOC(vector, (size_t)new_capacity * 
+                                 vector->stride);
+                if (data == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                memcpy(data, vector->data, 
+                       (size_t)vector->count * vector->stride);
+                DS__STATS_ADD(vector, memcpy_bytes, 
+                              (size_t)vector->count * vector->stride);
+        }
+
+        munmap(vector->map, vector->map_size);
+        vector->map = NULL;
+        vector->map_size = 0;
+        vector->read_only = 0;
+        vector->data = data;
+        vector->capacity = new_capacity;
+        return DS_NO_ERROR;
+}
+
+// change the capacity of the vector to exactly new_capacity items
+//
+// uses realloc so the storage can grow in place
+// a mapped vector is copied to the heap instead (read only ones refuse
+// with DS_READ_ONLY_ERROR), or just unmapped for capacity 0
+// new_capacity must not be less than count
+// returns 0 if no error
+static int ds__vector_resize_capacity(struct vector_t *vector, 
+                                      int new_capacity) {
+        if (vector->map != NULL && 
+            (new_capacity == 0 || new_capacity != vector->capacity)) {
+                return ds__vector_unmap(vector, new_capacity);
+        }
+        if (new_capacity == vector->capacity) {
+                return DS_NO_ERROR;
+        }
+
+        size_t old_capacity = vector->capacity;
+
+        if (new_capacity == 0) {
+                DS__FREE(vector, vector->items, 
+                        old_capacity * sizeof(void *));
+                DS__FREE(vector, vector->sizes, old_capacity * sizeof(int));
+                DS__FREE(vector, vector->data, 
+                        old_capacity * vector->stride);
+                vector->items = NULL;
+                vector->sizes = NULL;
+                vector->data = NULL;
+                vector->capacity = 0;
+                return DS_NO_ERROR;
+        }
+
+        if (vector->stride > 0) {
+                char *temp_data = DS__REALLOC(vector, vector->data,
+                                             old_capacity * vector->stride,
+                                             (size_t)new_capacity * 
+                                             vector->stride);
+                if (temp_data == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                vector->data = temp_data;
+                vector->capacity = new_capacity;
+                return DS_NO_ERROR;
+        }
+
+        void **temp_items = DS__REALLOC(vector, vector->items, 
+                                       old_capacity * sizeof(void *),
+                                       (size_t)new_capacity * 
+                                       sizeof(void *));
+        if (temp_items == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        vector->items = temp_items;
+
+        int *temp_sizes = DS__REALLOC(vector, vector->sizes, 
+                                     old_capacity * sizeof(int),
+                                     (size_t)new_capacity * sizeof(int));
+        if (temp_sizes == NULL) {
+                // shrink items back so both arrays match the capacity
+                temp_items = DS__REALLOC(vector, vector->items,
+                                        (size_t)new_capacity * 
+                                        sizeof(void *),
+                                        old_capacity * sizeof(void *));
+                if (temp_items != NULL) {
+                        vector->items = temp_items;
+                }
+                return DS_MALLOC_ERROR;
+        }
+        vector->sizes = temp_sizes;
+        vector->capacity = new_capacity;
+        return DS_NO_ERROR;
+}
+
+// grow the capacity of the vector so it can hold at least needed items
+//
+// the capacity is multiplied by the growth factor until it is enough
+// returns 0 if no error
+static int ds__vector_grow(struct vector_t *vector, int needed) {
+        if (needed <= vector->capacity) {
+                return DS_NO_ERROR;
+        }
+
+        double new_capacity = vector->capacity;
+        if (new_capacity < DS_VECTOR_MIN_CAPACITY) {
+                new_capacity = DS_VECTOR_MIN_CAPACITY;
+        }
+        while (new_capacity < needed) {
+                new_capacity *= vector->growth_factor;
+        }
+        if (new_capacity > INT_MAX) {
+                new_capacity = INT_MAX;
+        }
+        if ((int)new_capacity <= vector->capacity) {
+                new_capacity = needed;
+        }
+
+        DS__STATS_ADD(vector, grows, 1);
+        return ds__vector_resize_capacity(vector, (int)new_capacity);
+}
+
+// byte offset of ptr inside the items of a fixed stride vector
+//
+// returns -1 when ptr points somewhere else, a source found inside the
+// vector has to be found again after the vector grows
+static long long ds__vector_offset_of(struct vector_t *vector, 
+                                      const void *ptr) {
+        uintptr_t p = (uintptr_t)ptr;
+        uintptr_t start = (uintptr_t)vector->data;
+        if (vector->stride == 0 || vector->data == NULL || p < start || 
+            p - start >= (size_t)vector->count * vector->stride) {
+                return -1;
+        }
+        return (long long)(p - start);
+}
+
+// reserve space for at least capacity items
+//
+// never shrinks the vector
+// returns 0 if no error
+int vector_reserve(struct vector_t *vector, int capacity) {
+        if (vector == NULL || capacity < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (capacity <= vector->capacity) {
+                return DS_NO_ERROR;
+        }
+        return ds__vector_resize_capacity(vector, capacity);
+}
+
+// release the unused capacity of the vector
+//
+// returns 0 if no error
+int vector_shrink_to_fit(struct vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->map != NULL) {
+                // the mapping takes no heap memory
+                return DS_NO_ERROR;
+        }
+        return ds__vector_resize_capacity(vector, vector->count);
+}
+
+// remove all the items of the vector
+//
+// the capacity is kept so the vector can be refilled without allocating
+// returns 0 if no error
+int vector_clear(struct vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (vector->stride == 0) {
+                for (int i = 0; i < vector->count; i++) {
+                        DS__FREE(vector, vector->items[i], 
+                                vector->sizes[i]);
+                }
+        }
+        vector->count = 0;
+
+        return DS_NO_ERROR;
+}
+
+// append an item to the vector
+//
+// item may point into the vector itself
+// returns 0 if no error
+// grows the capacity by the growth factor if max capacity is reached
+int vector_append(struct vector_t *vector, void *item, int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->stride > 0 && vector->stride != size) {
+                return DS_SIZE_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+
+        if (vector->count >= vector->capacity) {
+                long long offset = ds__vector_offset_of(vector, item);
+                int err = ds__vector_grow(vector, vector->count + 1);
+                if (err) {
+                        return err;
+                }
+                if (offset >= 0) {
+                        item = vector->data + offset;
+                }
+        }
+
+        if (vector->stride > 0) {
+                memcpy(vector->data + (size_t)vector->count * vector->stride,
+                       item, size);
+                DS__STATS_ADD(vector, memcpy_bytes, size);
+                vector->count++;
+                return DS_NO_ERROR;
+        }
+
+        char *temp = DS__ALLOC(vector, size * sizeof(char));
+        if (temp == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        memcpy(temp, item, size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+
+        vector->sizes[vector->count] = size;
+        vector->items[vector->count] = temp;
+        vector->count++;
+
+        return DS_NO_ERROR;
+}
+
+// get the top value of the vector
+//
+// returns 0 if no error
+int vector_top(struct vector_t *vector, void *item, int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->count <= 0) {
+                return DS_EMPTY_ERROR;
+        }
+        if (ds__vector_item_size(vector, vector->count - 1) != size) {
+                return DS_SIZE_ERROR;
+        }
+
+        memcpy(item, ds__vector_item(vector, vector->count - 1), size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+
+        return DS_NO_ERROR;
+}
+
+// removes the last value of the vector
+//
+// returns 0 if no error
+int vector_pop(struct vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->count <= 0) {
+                return DS_EMPTY_ERROR;
+        }
+        
+        if (vector->stride == 0) {
+                DS__FREE(vector, vector->items[vector->count - 1],
+                        vector->sizes[vector->count - 1]);
+        }
+        vector->count--;
+
+        return DS_NO_ERROR;
+}
+
+// get the value at a specific index
+//
+// returns 0 if no error
+int vector_get(struct vector_t *vector, int index, void *item, int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= vector->count) {
+                return DS_RANGE_ERROR;
+        }
+        if (ds__vector_item_size(vector, index) != size) {
+                return DS_SIZE_ERROR;
+        }
+
+        memcpy(item, ds__vector_item(vector, index), size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+
+        return DS_NO_ERROR;
+}
+
+// set the value at a specific index
+//
+// for fixed size vectors the size must match the stride
+// returns 0 if no error
+int vector_set(struct vector_t *vector, int index, void *item, int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= vector->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        if (vector->stride > 0) {
+                if (vector->stride != size) {
+                        return DS_SIZE_ERROR;
+                }
+                int err = ds__vector_check_writable(vector);
+                if (err) {
+                        return err;
+                }
+                memcpy(vector->data + (size_t)index * vector->stride, item,
+                       size);
+                DS__STATS_ADD(vector, memcpy_bytes, size);
+                return DS_NO_ERROR;
+        }
+
+        char *temp = DS__ALLOC(vector, size * sizeof(char));
+        if (temp == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        DS__FREE(vector, vector->items[index], 
+                vector->sizes[index]);
+
+        vector->items[index] = temp;
+        vector->sizes[index] = size;
+        memcpy(vector->items[index], item, size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+
+        return DS_NO_ERROR;
+}
+
+// append count items stored one after the other in items
+//
+// every item is size bytes
+// items may point into the vector itself
+// the capacity grows at most once
+// returns 0 if no error
+int vector_append_many(struct vector_t *vector, void *items, int count,
+                       int size) {
+        if (vector == NULL || (items == NULL && count > 0) || count < 0 ||
+            size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->stride > 0 && vector->stride != size) {
+                return DS_SIZE_ERROR;
+        }
+        if (count > INT_MAX - vector->count) {
+                return DS_RANGE_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+
+        long long offset = ds__vector_offset_of(vector, items);
+        int err = ds__vector_grow(vector, vector->count + count);
+        if (err) {
+                return err;
+        }
+        if (offset >= 0) {
+                items = vector->data + offset;
+        }
+
+        if (vector->stride > 0) {
+                if (count > 0) {
+                        memcpy(vector->data + 
+                               (size_t)vector->count * vector->stride,
+                               items, (size_t)count * size);
+                }
+                DS__STATS_ADD(vector, memcpy_bytes, (long long)count * size);
+                vector->count += count;
+                return DS_NO_ERROR;
+        }
+
+        const char *item = items;
+        for (int i = 0; i < count; i++, item += size) {
+                char *temp = DS__ALLOC(vector, size);
+                if (temp == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                memcpy(temp, item, size);
+                DS__STATS_ADD(vector, memcpy_bytes, size);
+                vector->items[vector->count] = temp;
+                vector->sizes[vector->count] = size;
+                vector->count++;
+        }
+        return DS_NO_ERROR;
+}
+
+// check that [index, index + count) is a range of the vector
+static int ds__vector_check_range(struct vector_t *vector, int index, 
+                                  int count) {
+        if (index < 0 || count < 0 || index > vector->count || 
+            count > vector->count - index) {
+                return DS_RANGE_ERROR;
+        }
+        return DS_NO_ERROR;
+}
+
+// get count items starting at index into items
+//
+// every item must be size bytes
+// returns 0 if no error
+int vector_get_range(struct vector_t *vector, int index, int count, 
+                     void *items, int size) {
+        if (vector == NULL || (items == NULL && count > 0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int err = ds__vector_check_range(vector, index, count);
+        if (err) {
+                return err;
+        }
+
+        if (vector->stride > 0) {
+                if (vector->stride != size) {
+                        return DS_SIZE_ERROR;
+                }
+                if (count > 0) {
+                        memcpy(items, vector->data + 
+                                      (size_t)index * vector->stride,
+                               (size_t)count * size);
+                }
+                DS__STATS_ADD(vector, memcpy_bytes, (long long)count * size);
+                return DS_NO_ERROR;
+        }
+
+        for (int i = index; i < index + count; i++) {
+                if (vector->sizes[i] != size) {
+                        return DS_SIZE_ERROR;
+                }
+        }
+        char *item = items;
+        for (int i = index; i < index + count; i++, item += size) {
+                memcpy(item, vector->items[i], size);
+        }
+        DS__STATS_ADD(vector, memcpy_bytes, (long long)count * size);
+        return DS_NO_ERROR;
+}
+
+// set count items starting at index from items
+//
+// every item is size bytes
+// returns 0 if no error
+int vector_set_range(struct vector_t *vector, int index, int count, 
+                     void *items, int size) {
+        if (vector == NULL || (items == NULL && count > 0) || size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int err = ds__vector_check_range(vector, index, count);
+        if (err) {
+                return err;
+        }
+        err = ds__vector_check_writable(vector);
+        if (err) {
+                return err;
+        }
+
+        if (vector->stride > 0) {
+                if (vector->stride != size) {
+                        return DS_SIZE_ERROR;
+                }
+                if (count > 0) {
+                        memmove(vector->data + 
+                                (size_t)index * vector->stride,
+                                items, (size_t)count * size);
+                }
+                DS__STATS_ADD(vector, memcpy_bytes, (long long)count * size);
+                return DS_NO_ERROR;
+        }
+
+        const char *item = items;
+        for (int i = index; i < index + count; i++, item += size) {
+                err = vector_set(vector, i, (void *)item, size);
+                if (err) {
+                        return err;
+                }
+        }
+        return DS_NO_ERROR;
+}
+
+// insert an item at index, moving the following items up by one
+//
+// index may be equal to count, which is the same as vector_append
+// item may point into the vector itself, it is then copied aside before
+// the items move
+// returns 0 if no error
+int vector_insert(struct vector_t *vector, int index, void *item, int size) {
+        if (vector == NULL || item == NULL || size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index > vector->count) {
+                return DS_RANGE_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+        if (vector->stride > 0 && vector->stride != size) {
+                return DS_SIZE_ERROR;
+        }
+
+        char *copy = NULL;
+        if (ds__vector_offset_of(vector, item) >= 0) {
+                copy = DS__ALLOC(vector, size);
+                if (copy == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                memcpy(copy, item, size);
+                item = copy;
+        }
+        int err = ds__vector_grow(vector, vector->count + 1);
+        if (err) {
+                if (copy != NULL) {
+                        DS__FREE(vector, copy, size);
+                }
+                return err;
+        }
+
+        int after = vector->count - index;
+        if (vector->stride > 0) {
+                char *at = vector->data + (size_t)index * vector->stride;
+                memmove(at + vector->stride, at, (size_t)after * 
+                                                 vector->stride);
+                memcpy(at, item, size);
+                DS__STATS_ADD(vector, memcpy_bytes, 
+                              (long long)(after + 1) * size);
+                vector->count++;
+                if (copy != NULL) {
+                        DS__FREE(vector, copy, size);
+                }
+                return DS_NO_ERROR;
+        }
+
+        char *temp = DS__ALLOC(vector, size);
+        if (temp == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        memcpy(temp, item, size);
+        memmove(vector->items + index + 1, vector->items + index, 
+                (size_t)after * sizeof(void *));
+        memmove(vector->sizes + index + 1, vector->sizes + index, 
+                (size_t)after * sizeof(int));
+        vector->items[index] = temp;
+        vector->sizes[index] = size;
+        DS__STATS_ADD(vector, memcpy_bytes, size + (long long)after * 
+                                            (sizeof(void *) + sizeof(int)));
+        vector->count++;
+        return DS_NO_ERROR;
+}
+
+// remove count items starting at index, moving the following items down
+//
+// returns 0 if no error
+int vector_erase(struct vector_t *vector, int index, int count) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int err = ds__vector_check_range(vector, index, count);
+        if (err) {
+                return err;
+        }
+
+        int after = vector->count - index - count;
+        if (after > 0 && ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+        if (vector->stride > 0) {
+                char *at = vector->data + (size_t)index * vector->stride;
+                memmove(at, at + (size_t)count * vector->stride, 
+                        (size_t)after * vector->stride);
+                DS__STATS_ADD(vector, memcpy_bytes, 
+                              (long long)after * vector->stride);
+                vector->count -= count;
+                return DS_NO_ERROR;
+        }
+
+        for (int i = index; i < index + count; i++) {
+                DS__FREE(vector, vector->items[i], 
+                        vector->sizes[i]);
+        }
+        memmove(vector->items + index, vector->items + index + count, 
+                (size_t)after * sizeof(void *));
+        memmove(vector->sizes + index, vector->sizes + index + count, 
+                (size_t)after * sizeof(int));
+        DS__STATS_ADD(vector, memcpy_bytes, 
+                      (long long)after * (sizeof(void *) + sizeof(int)));
+        vector->count -= count;
+        return DS_NO_ERROR;
+}
+
+// change the number of items of the vector
+//
+// new items of a fixed size vector are zero filled
+// a variable size vector can only shrink, new items would have no size
+// returns 0 if no error
+int vector_resize(struct vector_t *vector, int count) {
+        if (vector == NULL || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (count <= vector->count) {
+                return vector_erase(vector, count, vector->count - count);
+        }
+        if (vector->stride == 0) {
+                return DS_SIZE_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+
+        int err = ds__vector_grow(vector, count);
+        if (err) {
+                return err;
+        }
+        memset(vector->data + (size_t)vector->count * vector->stride, 0,
+               (size_t)(count - vector->count) * vector->stride);
+        vector->count = count;
+        return DS_NO_ERROR;
+}
+
+// delete the vector
+//
+// frees the item space that was allocated
+// set count and capacity to zero
+int vector_delete(struct vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        vector_clear(vector);
+        return ds__vector_resize_capacity(vector, 0);
+}
+
+// get the counters of the vector
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int vector_stats(struct vector_t *vector, struct ds_stats_t *stats) {
+        if (vector == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = vector->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// an item of a variable sized vector while it is being sorted
+struct ds__sort_ref_t {
+        void *item;
+        int   size;
+};
+
+struct ds__sort_t {
+        int (*compare)(const void *a, const void *b);
+        size_t width;           // bytes per element
+        int indirect;           // elements are struct ds__sort_ref_t
+};
+
+static int ds__sort_compare(const struct ds__sort_t *sort, const char *a, 
+                            const char *b) {
+        if (sort->indirect) {
+                return sort->compare(((const struct ds__sort_ref_t *)a)->item,
+                                     ((const struct ds__sort_ref_t *)b)->item);
+        }
+        return sort->compare(a, b);
+}
+
+static void ds__sort_swap(char *a, char *b, size_t width) {
+        if (width == sizeof(uint32_t)) {
+                uint32_t x, y;
+                memcpy(&x, a, sizeof(x));
+                memcpy(&y, b, sizeof(y));
+                memcpy(a, &y, sizeof(y));
+                memcpy(b, &x, sizeof(x));
+                return;
+        }
+        if (width == sizeof(uint64_t)) {
+                uint64_t x, y;
+                memcpy(&x, a, sizeof(x));
+                memcpy(&y, b, sizeof(y));
+                memcpy(a, &y, sizeof(y));
+                memcpy(b, &x, sizeof(x));
+                return;
+        }
+
+        char tmp[64];
+        while (width > 0) {
+                size_t n = width < sizeof(tmp) ? width : sizeof(tmp);
+                memcpy(tmp, a, n);
+                memcpy(a, b, n);
+                memcpy(b, tmp, n);
+                a += n;
+                b += n;
+                width -= n;
+        }
+}
+
+#define DS__SORT_RUN 16
+
+static void ds__insertion_sort(const struct ds__sort_t *sort, char *base, 
+                               size_t n) {
+        size_t w = sort->width;
+        for (size_t i = 1; i < n; i++) {
+                for (size_t j = i; j > 0 && 
+                     ds__sort_compare(sort, base + (j - 1) * w, 
+                                      base + j * w) > 0; j--) {
+                        ds__sort_swap(base + (j - 1) * w, base + j * w, w);
+                }
+        }
+}
+
+static void ds__heap_sort(const struct ds__sort_t *sort, char *base, 
+                          size_t n) {
+        size_t w = sort->width;
+        for (size_t end = n, start = n / 2; end > 1;) {
+                if (start > 0) {
+                        start--;
+                } else {
+                        end--;
+                        ds__sort_swap(base, base + end * w, w);
+                }
+                size_t root = start;
+                for (size_t child; (child = 2 * root + 1) < end; 
+                     root = child) {
+                        if (child + 1 < end &&
+                            ds__sort_compare(sort, base + child * w,
+                                             base + (child + 1) * w) < 0) {
+                                child++;
+                        }
+                        if (ds__sort_compare(sort, base + root * w, 
+                                             base + child * w) >= 0) {
+                                break;
+                        }
+                        ds__sort_swap(base + root * w, base + child * w, w);
+                }
+        }
+}
+
+// quick sort falling back to heap sort when the partitions go bad
+static void ds__intro_sort(const struct ds__sort_t *sort, char *base, 
+                           size_t n, int depth) {
+        size_t w = sort->width;
+        while (n > DS__SORT_RUN) {
+                if (depth-- == 0) {
+                        ds__heap_sort(sort, base, n);
+                        return;
+                }
+
+                // median of three goes to the front as the pivot
+                char *a = base + w;
+                char *b = base + (n / 2) * w;
+                char *c = base + (n - 1) * w;
+                if (ds__sort_compare(sort, a, b) > 0) {
+                        ds__sort_swap(a, b, w);
+                }
+                if (ds__sort_compare(sort, b, c) > 0) {
+                        ds__sort_swap(b, c, w);
+                        if (ds__sort_compare(sort, a, b) > 0) {
+                                ds__sort_swap(a, b, w);
+                        }
+                }
+                ds__sort_swap(base, b, w);
+
+                // stop on equal items so duplicates split evenly
+                size_t i = 1;
+                size_t j = n - 1;
+                for (;;) {
+                        while (i <= j && 
+                               ds__sort_compare(sort, base + i * w, base) < 0) {
+                                i++;
+                        }
+                        while (i <= j && 
+                               ds__sort_compare(sort, base + j * w, base) > 0) {
+                                j--;
+                        }
+                        if (i >= j) {
+                                break;
+                        }
+                        ds__sort_swap(base + i * w, base + j * w, w);
+                        i++;
+                        j--;
+                }
+                ds__sort_swap(base, base + j * w, w);
+
+                // recurse into the smaller side
+                size_t left = j;
+                size_t right = n - j - 1;
+                if (left < right) {
+                        ds__intro_sort(sort, base, left, depth);
+                        base += (j + 1) * w;
+                        n = right;
+                } else {
+                        ds__intro_sort(sort, base + (j + 1) * w, right, depth);
+                        n = left;
+                }
+        }
+        ds__insertion_sort(sort, base, n);
+}
+
+static void ds__quick_sort(const struct ds__sort_t *sort, char *base, 
+                           size_t n) {
+        int depth = 0;
+        for (size_t m = n; m > 1; m >>= 1) {
+                depth += 2;
+        }
+        ds__intro_sort(sort, base, n, depth);
+}
+
+// merge two sorted runs into out, taking from left on ties
+static void ds__merge(const struct ds__sort_t *sort, const char *left, 
+                      size_t left_count, const char *right, 
+                      size_t right_count, char *out) {
+        size_t w = sort->width;
+        const char *left_end = left + left_count * w;
+        const char *right_end = right + right_count * w;
+        while (left < left_end && right < right_end) {
+                if (ds__sort_compare(sort, left, right) <= 0) {
+                        memcpy(out, left, w);
+                        left += w;
+                } else {
+                        memcpy(out, right, w);
+                        right += w;
+                }
+                out += w;
+        }
+        memcpy(out, left, left_end - left);
+        memcpy(out + (left_end - left), right, right_end - right);
+}
+
+// bottom up merge sort of base, scratch holds n elements
+static void ds__merge_sort(const struct ds__sort_t *sort, char *base, 
+                           char *scratch, size_t n) {
+        size_t w = sort->width;
+        for (size_t i = 0; i < n; i += DS__SORT_RUN) {
+                size_t run = n - i < DS__SORT_RUN ? n - i : DS__SORT_RUN;
+                ds__insertion_sort(sort, base + i * w, run);
+        }
+
+        char *src = base;
+        char *dst = scratch;
+        for (size_t width = DS__SORT_RUN; width < n; width *= 2) {
+                for (size_t i = 0; i < n; i += 2 * width) {
+                        size_t mid = i + width < n ? i + width : n;
+                        size_t end = i + 2 * width < n ? i + 2 * width : n;
+                        ds__merge(sort, src + i * w, mid - i, src + mid * w,
+                                  end - mid, dst + i * w);
+                }
+                char *tmp = src;
+                src = dst;
+                dst = tmp;
+        }
+        if (src != base) {
+                memcpy(base, src, n * w);
+        }
+}
+
+#ifndef DS_NO_THREADS
+
+struct ds__sort_task_t {
+        const struct ds__sort_t *sort;
+        char  *src;
+        char  *dst;
+        size_t begin;
+        size_t mid;
+        size_t end;
+};
+
+static void *ds__sort_chunk(void *arg) {
+        struct ds__sort_task_t *task = arg;
+        size_t w = task->sort->width;
+        ds__merge_sort(task->sort, task->src + task->begin * w, 
+                       task->dst + task->begin * w, task->end - task->begin);
+        return NULL;
+}
+
+static void *ds__merge_chunks(void *arg) {
+        struct ds__sort_task_t *task = arg;
+        size_t w = task->sort->width;
+        ds__merge(task->sort, task->src + task->begin * w, 
+                  task->mid - task->begin, task->src + task->mid * w, 
+                  task->end - task->mid, task->dst + task->begin * w);
+        return NULL;
+}
+
+// run the tasks on their own threads, the last one on this thread
+//
+// a task whose thread could not be started runs here as well
+static void ds__sort_run(void *(*fn)(void *), struct ds__sort_task_t *tasks,
+                         int count) {
+        pthread_t threads[DS_SORT_MAX_THREADS];
+        int started[DS_SORT_MAX_THREADS];
+        for (int i = 0; i < count - 1; i++) {
+                started[i] = pthread_create(&threads[i], NULL, fn, 
+                                            &tasks[i]) == 0;
+                if (!started[i]) {
+                        fn(&tasks[i]);
+                }
+        }
+        fn(&tasks[count - 1]);
+        for (int i = 0; i < count - 1; i++) {
+                if (started[i]) {
+                        pthread_join(threads[i], NULL);
+                }
+        }
+}
+
+static int ds__sort_threads(void) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = 1;
+        while (threads * 2 <= online && threads * 2 <= DS_SORT_MAX_THREADS) {
+                threads *= 2;
+        }
+        return threads;
+}
+
+// sort chunks in parallel, then merge pairs of chunks level by level
+static void ds__parallel_merge_sort(const struct ds__sort_t *sort, 
+                                    char *base, char *scratch, size_t n,
+                                    int threads) {
+        struct ds__sort_task_t tasks[DS_SORT_MAX_THREADS];
+        size_t bounds[DS_SORT_MAX_THREADS + 1];
+        for (int i = 0; i <= threads; i++) {
+                bounds[i] = n / threads * i;
+        }
+        bounds[threads] = n;
+
+        for (int i = 0; i < threads; i++) {
+                tasks[i] = (struct ds__sort_task_t){
+                        sort, base, scratch, bounds[i], 0, bounds[i + 1]
+                };
+        }
+        ds__sort_run(ds__sort_chunk, tasks, threads);
+
+        char *src = base;
+        char *dst = scratch;
+        for (int step = 1; step < threads; step *= 2) {
+                int count = 0;
+                for (int i = 0; i < threads; i += 2 * step) {
+                        tasks[count++] = (struct ds__sort_task_t){
+                                sort, src, dst, bounds[i], bounds[i + step],
+                                bounds[i + 2 * step]
+                        };
+                }
+                ds__sort_run(ds__merge_chunks, tasks, count);
+                char *tmp = src;
+                src = dst;
+                dst = tmp;
+        }
+        if (src != base) {
+                memcpy(base, src, n * sort->width);
+        }
+}
+
+#endif // DS_NO_THREADS
+
+// sort the elements, stable sorts always merge
+//
+// returns 0 if no error
+static int ds__vector_sort(struct vector_t *vector, 
+                           int (*compare)(const void *a, const void *b),
+                           int stable) {
+        if (vector == NULL || compare == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->count < 2) {
+                return DS_NO_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+
+        size_t n = vector->count;
+        struct ds__sort_t sort = { compare, vector->stride, 0 };
+        char *base = vector->data;
+        struct ds__sort_ref_t *refs = NULL;
+        if (vector->stride == 0) {
+                refs = DS__ALLOC(vector, n * sizeof(*refs));
+                if (refs == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                for (size_t i = 0; i < n; i++) {
+                        refs[i].item = vector->items[i];
+                        refs[i].size = vector->sizes[i];
+                }
+                sort.width = sizeof(*refs);
+                sort.indirect = 1;
+                base = (char *)refs;
+        }
+
+        int threads = 1;
+#ifndef DS_NO_THREADS
+        if (n >= DS_PARALLEL_SORT_MIN) {
+                threads = ds__sort_threads();
+        }
+#endif
+
+        int err = DS_NO_ERROR;
+        if (!stable && threads == 1) {
+                ds__quick_sort(&sort, base, n);
+        } else {
+                char *scratch = DS__ALLOC(vector, n * sort.width);
+                if (scratch == NULL) {
+                        err = DS_MALLOC_ERROR;
+                } else {
+#ifndef DS_NO_THREADS
+                        if (threads > 1) {
+                                ds__parallel_merge_sort(&sort, base, scratch, 
+                                                        n, threads);
+                        } else
+#endif
+                        {
+                                ds__merge_sort(&sort, base, scratch, n);
+                        }
+                        DS__FREE(vector, scratch, n * sort.width);
+                }
+        }
+
+        if (refs != NULL) {
+                if (err == DS_NO_ERROR) {
+                        for (size_t i = 0; i < n; i++) {
+                                vector->items[i] = refs[i].item;
+                                vector->sizes[i] = refs[i].size;
+                        }
+                }
+                DS__FREE(vector, refs, n * sizeof(*refs));
+        }
+        return err;
+}
+
+// sort the vector
+//
+// equal items may change their order
+// returns 0 if no error
+int vector_sort(struct vector_t *vector, 
+                int (*compare)(const void *a, const void *b)) {
+        return ds__vector_sort(vector, compare, 0);
+}
+
+// sort the vector keeping equal items in their order
+//
+// returns 0 if no error
+int vector_stable_sort(struct vector_t *vector, 
+                       int (*compare)(const void *a, const void *b)) {
+        return ds__vector_sort(vector, compare, 1);
+}
+
+// read an integer key so that unsigned comparison gives its order
+static uint64_t ds__radix_key(const char *item, int key_size, 
+                              int is_signed) {
+        uint64_t key;
+        switch (key_size) {
+        case 1: {
+                uint8_t k;
+                memcpy(&k, item, 1);
+                key = k;
+                break;
+        }
+        case 2: {
+                uint16_t k;
+                memcpy(&k, item, 2);
+                key = k;
+                break;
+        }
+        case 4: {
+                uint32_t k;
+                memcpy(&k, item, 4);
+                key = k;
+                break;
+        }
+        default:
+                memcpy(&key, item, 8);
+                break;
+        }
+        if (is_signed) {
+                key ^= (uint64_t)1 << (key_size * 8 - 1);
+        }
+        return key;
+}
+
+// sort a fixed stride vector by an integer key
+//
+// one pass per key byte, passes where every item has the same byte are
+// skipped, needs count extra items of scratch space
+// returns 0 if no error
+// returns DS_ARGUMENT_ERROR for variable sized vectors or a bad key
+int vector_radix_sort(struct vector_t *vector, int key_offset, int key_size,
+                      int is_signed) {
+        if (vector == NULL || vector->stride == 0 || key_offset < 0 ||
+            (key_size != 1 && key_size != 2 && key_size != 4 && 
+             key_size != 8) || key_offset + key_size > vector->stride) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->count < 2) {
+                return DS_NO_ERROR;
+        }
+        if (ds__vector_check_writable(vector)) {
+                return DS_READ_ONLY_ERROR;
+        }
+
+        size_t n = vector->count;
+        size_t w = vector->stride;
+        char *scratch = DS__ALLOC(vector, n * w);
+        if (scratch == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+
+        // count every byte of every key in one go
+        size_t (*counts)[256] = DS__ALLOC(vector, key_size * sizeof(*counts));
+        if (counts == NULL) {
+                DS__FREE(vector, scratch, n * w);
+                return DS_MALLOC_ERROR;
+        }
+        memset(counts, 0, key_size * sizeof(*counts));
+        for (size_t i = 0; i < n; i++) {
+                uint64_t key = ds__radix_key(vector->data + i * w + key_offset,
+                                             key_size, is_signed);
+                for (int b = 0; b < key_size; b++) {
+                        counts[b][(key >> (b * 8)) & 0xff]++;
+                }
+        }
+
+        char *src = vector->data;
+        char *dst = scratch;
+        for (int b = 0; b < key_size; b++) {
+                size_t offsets[256];
+                size_t total = 0;
+                int skip = 0;
+                for (int d = 0; d < 256; d++) {
+                        if (counts[b][d] == n) {
+                                skip = 1;
+                        }
+                        offsets[d] = total;
+                        total += counts[b][d];
+                }
+                if (skip) {
+                        continue;
+                }
+
+                for (size_t i = 0; i < n; i++) {
+                        const char *item = src + i * w;
+                        uint64_t key = ds__radix_key(item + key_offset, 
+                                                     key_size, is_signed);
+                        memcpy(dst + offsets[(key >> (b * 8)) & 0xff]++ * w, 
+                               item, w);
+                }
+                char *tmp = src;
+                src = dst;
+                dst = tmp;
+        }
+        if (src != vector->data) {
+                memcpy(vector->data, src, n * w);
+        }
+
+        DS__FREE(vector, counts, key_size * sizeof(*counts));
+        DS__FREE(vector, scratch, n * w);
+        return DS_NO_ERROR;
+}
+
+// find the first item that is not less than key
+//
+// index is count when every item is less than key
+// returns 0 if no error
+int vector_lower_bound(struct vector_t *vector, const void *key,
+                       int (*compare)(const void *key, const void *item),
+                       int *index) {
+        if (vector == NULL || compare == NULL || index == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int low = 0;
+        int high = vector->count;
+        while (low < high) {
+                int mid = low + (high - low) / 2;
+                if (compare(key, ds__vector_item(vector, mid)) > 0) {
+                        low = mid + 1;
+                } else {
+                        high = mid;
+                }
+        }
+        *index = low;
+        return DS_NO_ERROR;
+}
+
+// find an item equal to key
+//
+// index is the first such item
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if there is none
+int vector_bsearch(struct vector_t *vector, const void *key,
+                   int (*compare)(const void *key, const void *item),
+                   int *index) {
+        int low;
+        int err = vector_lower_bound(vector, key, compare, &low);
+        if (err != DS_NO_ERROR) {
+                return err;
+        }
+        if (low == vector->count || 
+            compare(key, ds__vector_item(vector, low)) != 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        *index = low;
+        return DS_NO_ERROR;
+}
+
+#define DS__VECTOR_FILE_MAGIC "DSVECTOR"
+#define DS__VECTOR_FILE_HEADER 64
+
+struct ds__vector_file_t {
+        char     magic[8];
+        uint32_t version;
+        uint32_t stride;
+        uint64_t count;
+        uint64_t checksum;
+};
+
+// checksum of the items, hashed a megabyte at a time
+static uint64_t ds__vector_checksum(const char *data, size_t size) {
+        uint64_t h = size;
+        size_t chunk = 1 << 20;
+        for (size_t i = 0; i < size; i += chunk) {
+                int n = (int)(size - i < chunk ? size - i : chunk);
+                h = (h ^ ds_hash_bytes(data + i, n)) * 0x9e3779b97f4a7c15ULL;
+        }
+        return h;
+}
+
+// save a fixed stride vector to a file
+//
+// the file is written next to path and renamed over it at the end, so
+// processes that still map the old file are not affected
+// returns 0 if no error
+// returns DS_ARGUMENT_ERROR for variable sized vectors
+// returns DS_IO_ERROR if the file could not be written
+int vector_save(struct vector_t *vector, const char *path) {
+        if (vector == NULL || path == NULL || vector->stride == 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        size_t size = (size_t)vector->count * vector->stride;
+        char header[DS__VECTOR_FILE_HEADER] = { 0 };
+        struct ds__vector_file_t file;
+        memcpy(file.magic, DS__VECTOR_FILE_MAGIC, sizeof(file.magic));
+        file.version = DS_VECTOR_FILE_VERSION;
+        file.stride = vector->stride;
+        file.count = vector->count;
+        file.checksum = ds__vector_checksum(vector->data, size);
+        memcpy(header, &file, sizeof(file));
+
+        size_t path_length = strlen(path);
+        size_t temp_size = path_length + sizeof(".tmp");
+        char *temp_path = DS__ALLOC(vector, temp_size);
+        if (temp_path == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        memcpy(temp_path, path, path_length);
+        memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+        int err = DS_NO_ERROR;
+        FILE *out = fopen(temp_path, "wb");
+        if (out == NULL) {
+                err = DS_IO_ERROR;
+        } else {
+                if (fwrite(header, 1, sizeof(header), out) != sizeof(header) ||
+                    (size > 0 && 
+                     fwrite(vector->data, 1, size, out) != size)) {
+                        err = DS_IO_ERROR;
+                }
+                if (fclose(out) != 0) {
+                        err = DS_IO_ERROR;
+                }
+                if (err == DS_NO_ERROR && rename(temp_path, path) != 0) {
+                        err = DS_IO_ERROR;
+                }
+                if (err != DS_NO_ERROR) {
+                        remove(temp_path);
+                }
+        }
+        DS__FREE(vector, temp_path, temp_size);
+        return err;
+}
+
+// open a file written by vector_save as a vector
+//
+// the vector must not be initialized, or deleted before
+// flags is VECTOR_MAP_READ_ONLY or VECTOR_MAP_COPY_ON_WRITE, optionally
+// with VECTOR_MAP_VERIFY
+// returns 0 if no error
+// returns DS_IO_ERROR if the file could not be opened or mapped
+// returns DS_FORMAT_ERROR if the file is not a vector file, is cut short
+// or does not match its checksum
+int vector_open(struct vector_t *vector, const char *path, int flags) {
+        if (vector == NULL || path == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+                return DS_IO_ERROR;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+                close(fd);
+                return DS_IO_ERROR;
+        }
+        if (st.st_size < DS__VECTOR_FILE_HEADER) {
+                close(fd);
+                return DS_FORMAT_ERROR;
+        }
+
+        int copy_on_write = flags & VECTOR_MAP_COPY_ON_WRITE;
+        size_t map_size = st.st_size;
+        void *map = mmap(NULL, map_size, 
+                         copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+                return DS_IO_ERROR;
+        }
+
+        struct ds__vector_file_t file;
+        memcpy(&file, map, sizeof(file));
+        char *data = (char *)map + DS__VECTOR_FILE_HEADER;
+        size_t available = map_size - DS__VECTOR_FILE_HEADER;
+        int err = DS_NO_ERROR;
+        if (memcmp(file.magic, DS__VECTOR_FILE_MAGIC, sizeof(file.magic)) ||
+            file.version != DS_VECTOR_FILE_VERSION || file.stride == 0 || 
+            file.stride > INT_MAX || file.count > INT_MAX ||
+            file.count > available / file.stride) {
+                err = DS_FORMAT_ERROR;
+        } else if ((flags & VECTOR_MAP_VERIFY) && 
+                   ds__vector_checksum(data, file.count * file.stride) != 
+                   file.checksum) {
+                err = DS_FORMAT_ERROR;
+        }
+        if (err != DS_NO_ERROR) {
+                munmap(map, map_size);
+                return err;
+        }
+
+        vector->items = NULL;
+        vector->sizes = NULL;
+        vector->data = data;
+        vector->stride = (int)file.stride;
+        vector->count = (int)file.count;
+        vector->capacity = (int)file.count;
+        vector->growth_factor = DS_VECTOR_GROWTH_FACTOR;
+        vector->allocator = NULL;
+        vector->map = map;
+        vector->map_size = map_size;
+        vector->read_only = !copy_on_write;
+        DS__STATS_INIT(vector);
+        return DS_NO_ERROR;
+}
+
+// initialize the packed vector
+//
+// returns 0 if no error
+int packed_vector_init(struct packed_vector_t *vector) {
+        return packed_vector_init_alloc(vector, NULL);
+}
+
+// initialize the packed vector with a custom allocator
+//
+// nothing is allocated until the first append
+// returns 0 if no error
+int packed_vector_init_alloc(struct packed_vector_t *vector,
+                             const struct ds_allocator_t *allocator) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        vector->bytes = NULL;
+        vector->used = 0;
+        vector->dead = 0;
+        vector->bytes_capacity = 0;
+        vector->entries = NULL;
+        vector->count = 0;
+        vector->capacity = 0;
+        vector->allocator = allocator;
+        DS__STATS_INIT(vector);
+        return DS_NO_ERROR;
+}
+
+// make room for at least count entries and bytes bytes of items
+//
+// never shrinks the vector
+// returns 0 if no error
+int packed_vector_reserve(struct packed_vector_t *vector, int count,
+                          size_t bytes) {
+        if (vector == NULL || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (count > vector->capacity) {
+                struct ds__packed_entry_t *entries = DS__REALLOC(
+                        vector, vector->entries, 
+                        (size_t)vector->capacity * sizeof(*entries),
+                        (size_t)count * sizeof(*entries));
+                if (entries == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                vector->entries = entries;
+                vector->capacity = count;
+        }
+        if (bytes > vector->bytes_capacity) {
+                char *temp = DS__REALLOC(vector, vector->bytes, 
+                                         vector->bytes_capacity, bytes);
+                if (temp == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                vector->bytes = temp;
+                vector->bytes_capacity = bytes;
+        }
+        return DS_NO_ERROR;
+}
+
+// copy item aside when it points into the bytes of the vector
+//
+// growing or compacting moves the bytes, so such an item is copied to
+// *copy first, *copy stays NULL for any other item
+// returns 0 if no error
+static int ds__packed_vector_hold(struct packed_vector_t *vector, 
+                                  const void **item, int size, 
+                                  char **copy) {
+        uintptr_t p = (uintptr_t)*item;
+        uintptr_t start = (uintptr_t)vector->bytes;
+        *copy = NULL;
+        if (size == 0 || vector->bytes == NULL || p < start || 
+            p - start >= vector->used) {
+                return DS_NO_ERROR;
+        }
+        *copy = DS__ALLOC(vector, size);
+        if (*copy == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        memcpy(*copy, *item, size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+        *item = *copy;
+        return DS_NO_ERROR;
+}
+
+// make room for one more entry and size more bytes
+//
+// compacts instead of growing the bytes when at least half of them are
+// dead and that frees enough room
+// returns 0 if no error
+static int ds__packed_vector_grow(struct packed_vector_t *vector, 
+                                  size_t size) {
+        int count = vector->capacity;
+        if (vector->count >= count) {
+                if (count == INT_MAX) {
+                        return DS_FULL_ERROR;
+                }
+                count = count < DS_VECTOR_MIN_CAPACITY ? 
+                        DS_VECTOR_MIN_CAPACITY : count;
+                count = count > INT_MAX / 2 ? INT_MAX : count * 2;
+        }
+
+        size_t bytes = vector->bytes_capacity;
+        if (vector->used + size > bytes) {
+                if (vector->dead >= vector->used / 2 && 
+                    vector->used - vector->dead + size <= bytes) {
+                        int err = packed_vector_compact(vector);
+                        if (err) {
+                                return err;
+                        }
+                } else {
+                        bytes = bytes < 64 ? 64 : bytes;
+                        while (bytes < vector->used + size) {
+                                bytes *= 2;
+                        }
+                        DS__STATS_ADD(vector, grows, 1);
+                }
+        }
+        return packed_vector_reserve(vector, count, bytes);
+}
+
+// append an item of any size to the end of the vector
+//
+// returns 0 if no error
+int packed_vector_append(struct packed_vector_t *vector, const void *item,
+                         int size) {
+        if (vector == NULL || (item == NULL && size > 0) || size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        char *copy;
+        int err = ds__packed_vector_hold(vector, &item, size, &copy);
+        if (err) {
+                return err;
+        }
+        err = ds__packed_vector_grow(vector, size);
+        if (err) {
+                if (copy != NULL) {
+                        DS__FREE(vector, copy, size);
+                }
+                return err;
+        }
+
+        struct ds__packed_entry_t *entry = &vector->entries[vector->count];
+        entry->offset = vector->used;
+        entry->size = size;
+        if (size > 0) {
+                memcpy(vector->bytes + vector->used, item, size);
+        }
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+        vector->used += size;
+        vector->count++;
+        if (copy != NULL) {
+                DS__FREE(vector, copy, size);
+        }
+        return DS_NO_ERROR;
+}
+
+// get the value at a specific index
+//
+// size must match the size the item was stored with
+// returns 0 if no error
+int packed_vector_get(struct packed_vector_t *vector, int index, void *item,
+                      int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= vector->count) {
+                return DS_RANGE_ERROR;
+        }
+        struct ds__packed_entry_t *entry = &vector->entries[index];
+        if (entry->size != size) {
+                return DS_SIZE_ERROR;
+        }
+
+        memcpy(item, vector->bytes + entry->offset, size);
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+        return DS_NO_ERROR;
+}
+
+// get a pointer to the item at a specific index and its size
+//
+// size may be NULL
+// returns 0 if no error
+int packed_vector_at(struct packed_vector_t *vector, int index, void **item,
+                     int *size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= vector->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        *item = vector->bytes + vector->entries[index].offset;
+        if (size != NULL) {
+                *size = vector->entries[index].size;
+        }
+        return DS_NO_ERROR;
+}
+
+// set the value at a specific index, the size may change
+//
+// returns 0 if no error
+int packed_vector_set(struct packed_vector_t *vector, int index, 
+                      const void *item, int size) {
+        if (vector == NULL || (item == NULL && size > 0) || size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= vector->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        struct ds__packed_entry_t *entry = &vector->entries[index];
+        char *copy = NULL;
+        if (size > entry->size) {
+                // the entry may move while growing, so it is looked up again
+                int old_size = entry->size;
+                int err = ds__packed_vector_hold(vector, &item, size, &copy);
+                if (err) {
+                        return err;
+                }
+                err = ds__packed_vector_grow(vector, size);
+                if (err) {
+                        if (copy != NULL) {
+                                DS__FREE(vector, copy, size);
+                        }
+                        return err;
+                }
+                entry = &vector->entries[index];
+                entry->offset = vector->used;
+                vector->used += size;
+                vector->dead += old_size;
+        } else {
+                vector->dead += entry->size - size;
+        }
+
+        // item may overlap the bytes it replaces
+        entry->size = size;
+        if (size > 0) {
+                memmove(vector->bytes + entry->offset, item, size);
+        }
+        DS__STATS_ADD(vector, memcpy_bytes, size);
+        if (copy != NULL) {
+                DS__FREE(vector, copy, size);
+        }
+        return DS_NO_ERROR;
+}
+
+// remove the last item
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if there is no item
+int packed_vector_pop(struct packed_vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->count <= 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        struct ds__packed_entry_t *entry = &vector->entries[--vector->count];
+        if (entry->offset + entry->size == vector->used) {
+                vector->used -= entry->size;
+        } else {
+                vector->dead += entry->size;
+        }
+        if (vector->count == 0) {
+                vector->used = 0;
+                vector->dead = 0;
+        }
+        return DS_NO_ERROR;
+}
+
+// pack the live items back to back in index order
+//
+// copies the live bytes into a new buffer of the same capacity and frees
+// the old one, so the dead bytes become free room at the end
+// returns 0 if no error
+int packed_vector_compact(struct packed_vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (vector->dead == 0) {
+                return DS_NO_ERROR;
+        }
+
+        // keep the old capacity, compaction makes room but never shrinks
+        size_t live = vector->used - vector->dead;
+        char *bytes = DS__ALLOC(vector, vector->bytes_capacity);
+        if (bytes == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        size_t offset = 0;
+        for (int i = 0; i < vector->count; i++) {
+                struct ds__packed_entry_t *entry = &vector->entries[i];
+                memcpy(bytes + offset, vector->bytes + entry->offset, 
+                       entry->size);
+                entry->offset = offset;
+                offset += entry->size;
+        }
+        DS__STATS_ADD(vector, memcpy_bytes, live);
+
+        DS__FREE(vector, vector->bytes, vector->bytes_capacity);
+        vector->bytes = bytes;
+        vector->used = live;
+        vector->dead = 0;
+        return DS_NO_ERROR;
+}
+
+// remove all the items and keep the allocated space
+//
+// returns 0 if no error
+int packed_vector_clear(struct packed_vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        vector->count = 0;
+        vector->used = 0;
+        vector->dead = 0;
+        return DS_NO_ERROR;
+}
+
+// delete the packed vector
+//
+// frees the bytes and the entries
+int packed_vector_delete(struct packed_vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        DS__FREE(vector, vector->bytes, vector->bytes_capacity);
+        DS__FREE(vector, vector->entries, 
+                 (size_t)vector->capacity * sizeof(*vector->entries));
+        return packed_vector_init_alloc(vector, vector->allocator);
+}
+
+// get the counters of the packed vector
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int packed_vector_stats(struct packed_vector_t *vector, 
+                        struct ds_stats_t *stats) {
+        if (vector == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = vector->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+#define DS__HEAP_ARITY 4
+
+// initialize the priority queue
+//
+// returns 0 if no error
+int priority_queue_init(struct priority_queue_t *queue, int stride,
+                        int (*compare)(const void *a, const void *b)) {
+        return priority_queue_init_alloc(queue, stride, compare, NULL);
+}
+
+// initialize the priority queue with a custom allocator
+//
+// nothing is allocated until the first push
+// returns 0 if no error
+int priority_queue_init_alloc(struct priority_queue_t *queue, int stride,
+                              int (*compare)(const void *a, const void *b),
+                              const struct ds_allocator_t *allocator) {
+        if (queue == NULL || stride <= 0 || compare == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        queue->data = NULL;
+        queue->handles = NULL;
+        queue->positions = NULL;
+        queue->stride = stride;
+        queue->count = 0;
+        queue->capacity = 0;
+        queue->handle_count = 0;
+        queue->free_handle = -1;
+        queue->compare = compare;
+        queue->allocator = allocator;
+        DS__STATS_INIT(queue);
+        return DS_NO_ERROR;
+}
+
+// reserve space for at least capacity items
+//
+// never shrinks the queue
+// returns 0 if no error
+int priority_queue_reserve(struct priority_queue_t *queue, int capacity) {
+        if (queue == NULL || capacity < 0 || capacity == INT_MAX) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (capacity <= queue->capacity) {
+                return DS_NO_ERROR;
+        }
+
+        // everything is allocated before anything is replaced, so a failed
+        // reserve leaves the queue as it was, at most capacity handles are
+        // live at once
+        size_t old_capacity = queue->capacity;
+        size_t stride = queue->stride;
+        char *data = DS__ALLOC(queue, ((size_t)capacity + 1) * stride);
+        int *handles = DS__ALLOC(queue, (size_t)capacity * sizeof(int));
+        int *positions = DS__ALLOC(queue, (size_t)capacity * sizeof(int));
+        if (data == NULL || handles == NULL || positions == NULL) {
+                if (data != NULL) {
+                        DS__FREE(queue, data, ((size_t)capacity + 1) * stride);
+                }
+                if (handles != NULL) {
+                        DS__FREE(queue, handles, 
+                                 (size_t)capacity * sizeof(int));
+                }
+                if (positions != NULL) {
+                        DS__FREE(queue, positions, 
+                                 (size_t)capacity * sizeof(int));
+                }
+                return DS_MALLOC_ERROR;
+        }
+
+        if (old_capacity > 0) {
+                memcpy(data, queue->data, (size_t)queue->count * stride);
+                memcpy(handles, queue->handles, 
+                       (size_t)queue->count * sizeof(int));
+                memcpy(positions, queue->positions, 
+                       (size_t)queue->handle_count * sizeof(int));
+                DS__STATS_ADD(queue, memcpy_bytes, 
+                              (long long)queue->count * stride + 
+                              ((long long)queue->count + 
+                               queue->handle_count) * sizeof(int));
+                DS__FREE(queue, queue->data, (old_capacity + 1) * stride);
+                DS__FREE(queue, queue->handles, old_capacity * sizeof(int));
+                DS__FREE(queue, queue->positions, 
+                         old_capacity * sizeof(int));
+        }
+        queue->data = data;
+        queue->handles = handles;
+        queue->positions = positions;
+        queue->capacity = capacity;
+        return DS_NO_ERROR;
+}
+
+static char *ds__heap_item(struct priority_queue_t *queue, int position) {
+        return queue->data + (size_t)position * queue->stride;
+}
+
+// put the item at the scratch slot with the given handle at position
+static void ds__heap_place(struct priority_queue_t *queue, int position,
+                           const char *item, int handle) {
+        memcpy(ds__heap_item(queue, position), item, queue->stride);
+        queue->handles[position] = handle;
+        queue->positions[handle] = position;
+}
+
+// move the item at position up until its parent comes first
+static void ds__heap_sift_up(struct priority_queue_t *queue, int position) {
+        char *moving = ds__heap_item(queue, queue->capacity);
+        int handle = queue->handles[position];
+        memcpy(moving, ds__heap_item(queue, position), queue->stride);
+
+        while (position > 0) {
+                int parent = (position - 1) / DS__HEAP_ARITY;
+                char *item = ds__heap_item(queue, parent);
+                if (queue->compare(moving, item) >= 0) {
+                        break;
+                }
+                ds__heap_place(queue, position, item, 
+                               queue->handles[parent]);
+                position = parent;
+        }
+        ds__heap_place(queue, position, moving, handle);
+}
+
+// move the item at position down until it comes before its children
+static void ds__heap_sift_down(struct priority_queue_t *queue, 
+                               int position) {
+        char *moving = ds__heap_item(queue, queue->capacity);
+        int handle = queue->handles[position];
+        memcpy(moving, ds__heap_item(queue, position), queue->stride);
+
+        for (;;) {
+                int first = position * DS__HEAP_ARITY + 1;
+                if (first >= queue->count) {
+                        break;
+                }
+                int last = first + DS__HEAP_ARITY;
+                last = last < queue->count ? last : queue->count;
+
+                int best = first;
+                char *best_item = ds__heap_item(queue, first);
+                for (int child = first + 1; child < last; child++) {
+                        char *item = ds__heap_item(queue, child);
+                        if (queue->compare(item, best_item) < 0) {
+                                best = child;
+                                best_item = item;
+                        }
+                }
+                if (queue->compare(best_item, moving) >= 0) {
+                        break;
+                }
+                ds__heap_place(queue, position, best_item, 
+                               queue->handles[best]);
+                position = best;
+        }
+        ds__heap_place(queue, position, moving, handle);
+}
+
+// get a handle for a new item, reusing freed ones first
+static int ds__heap_take_handle(struct priority_queue_t *queue) {
+        if (queue->free_handle >= 0) {
+                int handle = queue->free_handle;
+                queue->free_handle = -queue->positions[handle] - 2;
+                return handle;
+        }
+        return queue->handle_count++;
+}
+
+static void ds__heap_free_handle(struct priority_queue_t *queue, 
+                                 int handle) {
+        queue->positions[handle] = -queue->free_handle - 2;
+        queue->free_handle = handle;
+}
+
+// replace the contents of the queue with count items
+//
+// the heap is built bottom up in O(count), the items get the handles
+// 0 to count - 1 in the order they are given
+// returns 0 if no error
+int priority_queue_heapify(struct priority_queue_t *queue, const void *items,
+                           int count, int size) {
+        if (queue == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+
+        int err = priority_queue_reserve(queue, count);
+        if (err) {
+                return err;
+        }
+        if (count > 0) {
+                memcpy(queue->data, items, (size_t)count * size);
+                DS__STATS_ADD(queue, memcpy_bytes, (size_t)count * size);
+        }
+        for (int i = 0; i < count; i++) {
+                queue->handles[i] = i;
+                queue->positions[i] = i;
+        }
+        queue->count = count;
+        queue->handle_count = count;
+        queue->free_handle = -1;
+
+        for (int i = (count - 2) / DS__HEAP_ARITY; i >= 0 && count > 1; i--) {
+                ds__heap_sift_down(queue, i);
+        }
+        return DS_NO_ERROR;
+}
+
+// push an item into the queue
+//
+// handle may be NULL
+// returns 0 if no error
+int priority_queue_push(struct priority_queue_t *queue, const void *item, 
+                        int size, int *handle) {
+        if (queue == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+
+        if (queue->count >= queue->capacity) {
+                int capacity = queue->capacity < DS_VECTOR_MIN_CAPACITY ?
+                               DS_VECTOR_MIN_CAPACITY : queue->capacity;
+                capacity = capacity > INT_MAX / 2 ? INT_MAX - 1 : 
+                           capacity * 2;
+                if (capacity <= queue->count) {
+                        return DS_FULL_ERROR;
+                }
+                int err = priority_queue_reserve(queue, capacity);
+                if (err) {
+                        return err;
+                }
+                DS__STATS_ADD(queue, grows, 1);
+        }
+
+        int taken = ds__heap_take_handle(queue);
+        int position = queue->count++;
+        ds__heap_place(queue, position, item, taken);
+        DS__STATS_ADD(queue, memcpy_bytes, size);
+        ds__heap_sift_up(queue, position);
+        if (handle != NULL) {
+                *handle = taken;
+        }
+        return DS_NO_ERROR;
+}
+
+// get the item that comes out next without removing it
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the queue is empty
+int priority_queue_peek(struct priority_queue_t *queue, void *item, 
+                        int size) {
+        if (queue == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (queue->count == 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        memcpy(item, queue->data, size);
+        return DS_NO_ERROR;
+}
+
+// remove the item at position, the last item takes its place
+static void ds__heap_remove_at(struct priority_queue_t *queue, 
+                               int position) {
+        ds__heap_free_handle(queue, queue->handles[position]);
+        int last = --queue->count;
+        if (position == last) {
+                return;
+        }
+
+        ds__heap_place(queue, position, ds__heap_item(queue, last), 
+                       queue->handles[last]);
+        int parent = (position - 1) / DS__HEAP_ARITY;
+        if (position > 0 && 
+            queue->compare(ds__heap_item(queue, position), 
+                           ds__heap_item(queue, parent)) < 0) {
+                ds__heap_sift_up(queue, position);
+        } else {
+                ds__heap_sift_down(queue, position);
+        }
+}
+
+// remove the item that comes out next
+//
+// item may be NULL, its handle is freed
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the queue is empty
+int priority_queue_pop(struct priority_queue_t *queue, void *item, int size) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (queue->count == 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        if (item != NULL) {
+                memcpy(item, queue->data, size);
+        }
+        ds__heap_remove_at(queue, 0);
+        return DS_NO_ERROR;
+}
+
+// get the position of a live handle
+//
+// returns -1 if the handle is not in the queue
+static int ds__heap_position(struct priority_queue_t *queue, int handle) {
+        if (handle < 0 || handle >= queue->handle_count) {
+                return -1;
+        }
+        return queue->positions[handle] < 0 ? -1 : queue->positions[handle];
+}
+
+// get the item with the given handle
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the handle is not in the queue
+int priority_queue_get(struct priority_queue_t *queue, int handle, 
+                       void *item, int size) {
+        if (queue == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+        int position = ds__heap_position(queue, handle);
+        if (position < 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+
+        memcpy(item, ds__heap_item(queue, position), size);
+        return DS_NO_ERROR;
+}
+
+// change the item with the given handle and restore the heap
+//
+// works for decrease-key as well as increase-key
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the handle is not in the queue
+int priority_queue_update(struct priority_queue_t *queue, int handle, 
+                          const void *item, int size) {
+        if (queue == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->stride) {
+                return DS_SIZE_ERROR;
+        }
+        int position = ds__heap_position(queue, handle);
+        if (position < 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+
+        int earlier = queue->compare(item, ds__heap_item(queue, position)) < 0;
+        memcpy(ds__heap_item(queue, position), item, size);
+        DS__STATS_ADD(queue, memcpy_bytes, size);
+        if (earlier) {
+                ds__heap_sift_up(queue, position);
+        } else {
+                ds__heap_sift_down(queue, position);
+        }
+        return DS_NO_ERROR;
+}
+
+// remove the item with the given handle
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the handle is not in the queue
+int priority_queue_remove(struct priority_queue_t *queue, int handle) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int position = ds__heap_position(queue, handle);
+        if (position < 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+
+        ds__heap_remove_at(queue, position);
+        return DS_NO_ERROR;
+}
+
+// remove all the items and keep the allocated space
+//
+// all the handles become invalid
+// returns 0 if no error
+int priority_queue_clear(struct priority_queue_t *queue) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        queue->count = 0;
+        queue->handle_count = 0;
+        queue->free_handle = -1;
+        return DS_NO_ERROR;
+}
+
+// delete the priority queue
+//
+// frees the items and the handles
+int priority_queue_delete(struct priority_queue_t *queue) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        size_t capacity = queue->capacity;
+        if (capacity > 0) {
+                DS__FREE(queue, queue->data, (capacity + 1) * queue->stride);
+        }
+        DS__FREE(queue, queue->handles, capacity * sizeof(int));
+        DS__FREE(queue, queue->positions, capacity * sizeof(int));
+        return priority_queue_init_alloc(queue, queue->stride, 
+                                         queue->compare, queue->allocator);
+}
+
+// get the counters of the priority queue
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int priority_queue_stats(struct priority_queue_t *queue, 
+                         struct ds_stats_t *stats) {
+        if (queue == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = queue->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// initialize the deque
+//
+// returns 0 if no error
+int deque_init(struct deque_t *deque, int stride) {
+        return deque_init_alloc(deque, stride, NULL);
+}
+
+// initialize the deque with a custom allocator
+//
+// nothing is allocated until the first push
+// returns 0 if no error
+int deque_init_alloc(struct deque_t *deque, int stride,
+                     const struct ds_allocator_t *allocator) {
+        if (deque == NULL || stride <= 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        deque->data = NULL;
+        deque->stride = stride;
+        deque->head = 0;
+        deque->count = 0;
+        deque->capacity = 0;
+        deque->allocator = allocator;
+        DS__STATS_INIT(deque);
+        return DS_NO_ERROR;
+}
+
+// address of the item index places after the front
+static char *ds__deque_item(struct deque_t *deque, int index) {
+        int position = (deque->head + index) & (deque->capacity - 1);
+        return deque->data + (size_t)position * deque->stride;
+}
+
+// reserve space for at least capacity items
+//
+// the capacity is rounded up to a power of two, the items are unwrapped
+// so the front item ends up at the start of the new buffer
+// returns 0 if no error
+int deque_reserve(struct deque_t *deque, int capacity) {
+        if (deque == NULL || capacity < 0 || capacity > (INT_MAX >> 1) + 1) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (capacity <= deque->capacity) {
+                return DS_NO_ERROR;
+        }
+
+        int new_capacity = DS_VECTOR_MIN_CAPACITY;
+        while (new_capacity < capacity) {
+                new_capacity <<= 1;
+        }
+        size_t stride = deque->stride;
+        char *data = DS__ALLOC(deque, (size_t)new_capacity * stride);
+        if (data == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+
+        if (deque->count > 0) {
+                int first = deque->capacity - deque->head;
+                first = first < deque->count ? first : deque->count;
+                memcpy(data, ds__deque_item(deque, 0), first * stride);
+                memcpy(data + first * stride, deque->data, 
+                       (deque->count - first) * stride);
+                DS__STATS_ADD(deque, memcpy_bytes, deque->count * stride);
+        }
+        DS__FREE(deque, deque->data, (size_t)deque->capacity * stride);
+        deque->data = data;
+        deque->head = 0;
+        deque->capacity = new_capacity;
+        return DS_NO_ERROR;
+}
+
+// make room for count more items
+//
+// returns 0 if no error
+static int ds__deque_grow(struct deque_t *deque, int count) {
+        if (count > INT_MAX - deque->count) {
+                return DS_FULL_ERROR;
+        }
+        int needed = deque->count + count;
+        if (needed <= deque->capacity) {
+                return DS_NO_ERROR;
+        }
+        if (needed > (INT_MAX >> 1) + 1) {
+                return DS_FULL_ERROR;
+        }
+
+        // capacity is at most 2^29 here, doubling it can not overflow
+        int capacity = deque->capacity * 2;
+        DS__STATS_ADD(deque, grows, 1);
+        return deque_reserve(deque, capacity > needed ? capacity : needed);
+}
+
+// push an item after the back item
+//
+// returns 0 if no error
+int deque_push_back(struct deque_t *deque, const void *item, int size) {
+        if (deque == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+
+        int err = ds__deque_grow(deque, 1);
+        if (err) {
+                return err;
+        }
+        memcpy(ds__deque_item(deque, deque->count), item, size);
+        DS__STATS_ADD(deque, memcpy_bytes, size);
+        deque->count++;
+        return DS_NO_ERROR;
+}
+
+// push an item before the front item
+//
+// returns 0 if no error
+int deque_push_front(struct deque_t *deque, const void *item, int size) {
+        if (deque == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+
+        int err = ds__deque_grow(deque, 1);
+        if (err) {
+                return err;
+        }
+        deque->head = (deque->head - 1) & (deque->capacity - 1);
+        memcpy(ds__deque_item(deque, 0), item, size);
+        DS__STATS_ADD(deque, memcpy_bytes, size);
+        deque->count++;
+        return DS_NO_ERROR;
+}
+
+// push count items after the back item, in order
+//
+// grows at most once and copies with at most two memcpy calls
+// returns 0 if no error
+int deque_push_back_many(struct deque_t *deque, const void *items, 
+                         int count, int size) {
+        if (deque == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (count == 0) {
+                return DS_NO_ERROR;
+        }
+
+        int err = ds__deque_grow(deque, count);
+        if (err) {
+                return err;
+        }
+        int tail = (deque->head + deque->count) & (deque->capacity - 1);
+        int first = deque->capacity - tail;
+        first = first < count ? first : count;
+        memcpy(deque->data + (size_t)tail * size, items, (size_t)first * size);
+        memcpy(deque->data, (const char *)items + (size_t)first * size,
+               (size_t)(count - first) * size);
+        DS__STATS_ADD(deque, memcpy_bytes, (size_t)count * size);
+        deque->count += count;
+        return DS_NO_ERROR;
+}
+
+// remove the back item
+//
+// item may be NULL
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the deque is empty
+int deque_pop_back(struct deque_t *deque, void *item, int size) {
+        if (deque == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (deque->count == 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        deque->count--;
+        if (item != NULL) {
+                memcpy(item, ds__deque_item(deque, deque->count), size);
+        }
+        return DS_NO_ERROR;
+}
+
+// remove the front item
+//
+// item may be NULL
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the deque is empty
+int deque_pop_front(struct deque_t *deque, void *item, int size) {
+        if (deque == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (deque->count == 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        if (item != NULL) {
+                memcpy(item, ds__deque_item(deque, 0), size);
+        }
+        deque->head = (deque->head + 1) & (deque->capacity - 1);
+        deque->count--;
+        return DS_NO_ERROR;
+}
+
+// remove up to count items from the front, in order
+//
+// items may be NULL to drop them, popped may be NULL
+// returns 0 if at least one item was popped
+// returns DS_EMPTY_ERROR if the deque is empty
+int deque_pop_front_many(struct deque_t *deque, void *items, int count,
+                         int size, int *popped) {
+        if (deque == NULL || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (deque->count == 0 && count > 0) {
+                return DS_EMPTY_ERROR;
+        }
+
+        int n = count < deque->count ? count : deque->count;
+        if (items != NULL && n > 0) {
+                int first = deque->capacity - deque->head;
+                first = first < n ? first : n;
+                memcpy(items, ds__deque_item(deque, 0), (size_t)first * size);
+                memcpy((char *)items + (size_t)first * size, deque->data,
+                       (size_t)(n - first) * size);
+        }
+        if (n > 0) {
+                deque->head = (deque->head + n) & (deque->capacity - 1);
+                deque->count -= n;
+        }
+        if (popped != NULL) {
+                *popped = n;
+        }
+        return DS_NO_ERROR;
+}
+
+// get the front item without removing it
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the deque is empty
+int deque_front(struct deque_t *deque, void *item, int size) {
+        int err = deque_get(deque, 0, item, size);
+        return err == DS_RANGE_ERROR ? DS_EMPTY_ERROR : err;
+}
+
+// get the back item without removing it
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the deque is empty
+int deque_back(struct deque_t *deque, void *item, int size) {
+        if (deque == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int err = deque_get(deque, deque->count - 1, item, size);
+        return err == DS_RANGE_ERROR ? DS_EMPTY_ERROR : err;
+}
+
+// get the item index places after the front
+//
+// returns 0 if no error
+int deque_get(struct deque_t *deque, int index, void *item, int size) {
+        if (deque == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (index < 0 || index >= deque->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        memcpy(item, ds__deque_item(deque, index), size);
+        return DS_NO_ERROR;
+}
+
+// set the item index places after the front
+//
+// returns 0 if no error
+int deque_set(struct deque_t *deque, int index, const void *item, int size) {
+        if (deque == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != deque->stride) {
+                return DS_SIZE_ERROR;
+        }
+        if (index < 0 || index >= deque->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        memcpy(ds__deque_item(deque, index), item, size);
+        DS__STATS_ADD(deque, memcpy_bytes, size);
+        return DS_NO_ERROR;
+}
+
+// remove all the items and keep the allocated space
+//
+// returns 0 if no error
+int deque_clear(struct deque_t *deque) {
+        if (deque == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        deque->head = 0;
+        deque->count = 0;
+        return DS_NO_ERROR;
+}
+
+// delete the deque
+//
+// frees the buffer
+int deque_delete(struct deque_t *deque) {
+        if (deque == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        DS__FREE(deque, deque->data, (size_t)deque->capacity * deque->stride);
+        return deque_init_alloc(deque, deque->stride, deque->allocator);
+}
+
+// get the counters of the deque
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int deque_stats(struct deque_t *deque, struct ds_stats_t *stats) {
+        if (deque == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = deque->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+#define DS__HASH_MAP_EMPTY 0x80
+
+// count trailing zeros of a non zero mask
+static int ds__ctz(unsigned mask) {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int n = 0;
+        while (!(mask & 1)) {
+                mask >>= 1;
+                n++;
+        }
+        return n;
+#endif
+}
+
+// bit i is set when ctrl[i] == h2, for the 16 bytes starting at ctrl
+static unsigned ds__group_match(const unsigned char *ctrl, unsigned char h2) {
+#if defined(__SSE2__)
+        __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+        return (unsigned)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < DS_HASH_MAP_GROUP; i++) {
+                mask |= (unsigned)(ctrl[i] == h2) << i;
+        }
+        return mask;
+#endif
+}
+
+// bit i is set when ctrl[i] is empty, for the 16 bytes starting at ctrl
+static unsigned ds__group_empty(const unsigned char *ctrl) {
+#if defined(__SSE2__)
+        // only the empty control byte has its high bit set
+        __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+        return (unsigned)_mm_movemask_epi8(group);
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < DS_HASH_MAP_GROUP; i++) {
+                mask |= (unsigned)(ctrl[i] == DS__HASH_MAP_EMPTY) << i;
+        }
+        return mask;
+#endif
+}
+
+// hash size bytes of key
+//
+// processes 8 bytes at a time and finishes with the murmur3 mixer
+uint64_t ds_hash_bytes(const void *key, int size) {
+        const unsigned char *p = key;
+        uint64_t h = 0x9e3779b97f4a7c15ULL ^ ((uint64_t)size * 
+                                               0xff51afd7ed558ccdULL);
+        while (size >= 8) {
+                uint64_t chunk;
+                memcpy(&chunk, p, 8);
+                h = (h ^ (chunk * 0xc4ceb9fe1a85ec53ULL)) * 
+                    0x9e3779b97f4a7c15ULL;
+                h ^= h >> 29;
+                p += 8;
+                size -= 8;
+        }
+        if (size > 0) {
+                uint64_t chunk = 0;
+                memcpy(&chunk, p, size);
+                h = (h ^ (chunk * 0xc4ceb9fe1a85ec53ULL)) * 
+                    0x9e3779b97f4a7c15ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+}
+
+int ds_equal_bytes(const void *a, const void *b, int size) {
+        return memcmp(a, b, size) == 0;
+}
+
+uint64_t ds_hash_cstr(const void *key, int size) {
+        (void)size;
+        const char *str = *(const char * const *)key;
+        return ds_hash_bytes(str, (int)strlen(str));
+}
+
+int ds_equal_cstr(const void *a, const void *b, int size) {
+        (void)size;
+        return strcmp(*(const char * const *)a, *(const char * const *)b) == 0;
+}
+
+uint64_t ds_hash_string_view(const void *key, int size) {
+        (void)size;
+        const struct string_view_t *view = key;
+        return ds_hash_bytes(view->data, view->length);
+}
+
+int ds_equal_string_view(const void *a, const void *b, int size) {
+        (void)size;
+        const struct string_view_t *va = a, *vb = b;
+        return va->length == vb->length && 
+               memcmp(va->data, vb->data, va->length) == 0;
+}
+
+// alignment to use for an item of the given size
+static int ds__align_of_size(int size) {
+        int align = size & -size;
+        if (align == 0) {
+                return 1;
+        }
+        return align > 16 ? 16 : align;
+}
+
+// initialize the hash map
+//
+// returns 0 if no error
+int hash_map_init(struct hash_map_t *map, int key_size, int value_size,
+                  uint64_t (*hash)(const void *key, int size),
+                  int (*equal)(const void *a, const void *b, int size)) {
+        return hash_map_init_alloc(map, key_size, value_size, hash, equal, 
+                                   NULL);
+}
+
+// initialize the hash map with a custom allocator
+//
+// no memory is allocated until the first put or reserve
+// returns 0 if no error
+int hash_map_init_alloc(struct hash_map_t *map, int key_size, 
+                        int value_size,
+                        uint64_t (*hash)(const void *key, int size),
+                        int (*equal)(const void *a, const void *b, int size),
+                        const struct ds_allocator_t *allocator) {
+        if (map == NULL || key_size <= 0 || value_size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int key_align = ds__align_of_size(key_size);
+        int value_align = ds__align_of_size(value_size);
+        int slot_align = key_align > value_align ? key_align : value_align;
+
+        map->ctrl = NULL;
+        map->slots = NULL;
+        map->key_size = key_size;
+        map->value_size = value_size;
+        map->value_offset = (key_size + value_align - 1) & -value_align;
+        map->slot_size = (map->value_offset + value_size + slot_align - 1) &
+                         -slot_align;
+        map->count = 0;
+        map->capacity = 0;
+        map->hash = hash ? hash : ds_hash_bytes;
+        map->equal = equal ? equal : ds_equal_bytes;
+        map->allocator = allocator;
+        DS__STATS_INIT(map);
+        return DS_NO_ERROR;
+}
+
+// number of bytes used by the control bytes, the slots follow aligned
+static size_t ds__hash_map_ctrl_bytes(int capacity) {
+        return ((size_t)capacity + DS_HASH_MAP_GROUP - 1 + 15) & ~(size_t)15;
+}
+
+static size_t ds__hash_map_block_bytes(struct hash_map_t *map, 
+                                       int capacity) {
+        return ds__hash_map_ctrl_bytes(capacity) + 
+               (size_t)capacity * map->slot_size;
+}
+
+static char *ds__hash_map_slot(struct hash_map_t *map, int index) {
+        return map->slots + (size_t)index * map->slot_size;
+}
+
+// set a control byte, the first group is mirrored after the last slot
+// so a group can be loaded from any index without wrapping
+static void ds__hash_map_set_ctrl(struct hash_map_t *map, int index,
+                                  unsigned char value) {
+        map->ctrl[index] = value;
+        if (index < DS_HASH_MAP_GROUP - 1) {
+                map->ctrl[map->capacity + index] = value;
+        }
+}
+
+// find the slot of a key
+//
+// returns the index of the slot or -1 if the key is not present
+static int ds__hash_map_find_index(struct hash_map_t *map, const void *key,
+                                   uint64_t hash) {
+        if (map->capacity == 0) {
+                return -1;
+        }
+
+        int mask = map->capacity - 1;
+        unsigned char h2 = hash & 0x7f;
+        int pos = (int)(hash >> 7) & mask;
+        for (int probed = 0; probed < map->capacity; 
+             probed += DS_HASH_MAP_GROUP) {
+                const unsigned char *group = map->ctrl + pos;
+                unsigned match = ds__group_match(group, h2);
+                unsigned empty = ds__group_empty(group);
+                if (empty) {
+                        // probing is linear, nothing after an empty slot
+                        match &= (empty & -empty) - 1;
+                }
+                while (match) {
+                        int index = (pos + ds__ctz(match)) & mask;
+                        if (map->equal(ds__hash_map_slot(map, index), key,
+                                       map->key_size)) {
+                                return index;
+                        }
+                        match &= match - 1;
+                }
+                if (empty) {
+                        return -1;
+                }
+                pos = (pos + DS_HASH_MAP_GROUP) & mask;
+        }
+        return -1;
+}
+
+// find the first empty slot for a hash
+//
+// there is always one since the load is kept below 7/8
+static int ds__hash_map_find_empty(struct hash_map_t *map, uint64_t hash) {
+        int mask = map->capacity - 1;
+        int pos = (int)(hash >> 7) & mask;
+        for (;;) {
+                unsigned empty = ds__group_empty(map->ctrl + pos);
+                if (empty) {
+                        return (pos + ds__ctz(empty)) & mask;
+                }
+                pos = (pos + DS_HASH_MAP_GROUP) & mask;
+        }
+}
+
+// move every item into new storage of new_capacity slots
+//
+// returns 0 if no error
+static int ds__hash_map_rehash(struct hash_map_t *map, int new_capacity) {
+        size_t block_bytes = ds__hash_map_block_bytes(map, new_capacity);
+        char *block = DS__ALLOC(map, block_bytes);
+        if (block == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+
+        unsigned char *old_ctrl = map->ctrl;
+        char *old_slots = map->slots;
+        int old_capacity = map->capacity;
+
+        map->ctrl = (unsigned char *)block;
+        map->slots = block + ds__hash_map_ctrl_bytes(new_capacity);
+        map->capacity = new_capacity;
+        memset(map->ctrl, DS__HASH_MAP_EMPTY, 
+               new_capacity + DS_HASH_MAP_GROUP - 1);
+
+        for (int i = 0; i < old_capacity; i++) {
+                if (old_ctrl[i] & DS__HASH_MAP_EMPTY) {
+                        continue;
+                }
+                char *slot = old_slots + (size_t)i * map->slot_size;
+                uint64_t hash = map->hash(slot, map->key_size);
+                int index = ds__hash_map_find_empty(map, hash);
+                ds__hash_map_set_ctrl(map, index, hash & 0x7f);
+                memcpy(ds__hash_map_slot(map, index), slot, map->slot_size);
+        }
+        DS__STATS_ADD(map, memcpy_bytes, (long long)map->count * 
+                                         map->slot_size);
+        if (new_capacity > old_capacity) {
+                DS__STATS_ADD(map, grows, 1);
+        }
+
+        if (old_capacity > 0) {
+                DS__FREE(map, old_ctrl, 
+                        ds__hash_map_block_bytes(map, old_capacity));
+        }
+        return DS_NO_ERROR;
+}
+
+// make room for at least count items
+//
+// returns 0 if no error
+int hash_map_reserve(struct hash_map_t *map, int count) {
+        if (map == NULL || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        // keep the load at most 7/8
+        long long needed = ((long long)count * 8 + 6) / 7;
+        long long capacity = map->capacity ? map->capacity : 
+                             DS_HASH_MAP_GROUP;
+        while (capacity < needed || capacity * 7 < (long long)count * 8) {
+                capacity *= 2;
+        }
+        if (capacity > INT_MAX / 2) {
+                return DS_MALLOC_ERROR;
+        }
+        if (capacity == map->capacity) {
+                return DS_NO_ERROR;
+        }
+        return ds__hash_map_rehash(map, (int)capacity);
+}
+
+// insert a key or overwrite its value
+//
+// returns 0 if no error
+int hash_map_put(struct hash_map_t *map, const void *key, 
+                 const void *value) {
+        if (map == NULL || key == NULL || 
+            (value == NULL && map->value_size > 0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        uint64_t hash = map->hash(key, map->key_size);
+        int index = ds__hash_map_find_index(map, key, hash);
+        if (index < 0) {
+                if ((long long)(map->count + 1) * 8 > 
+                    (long long)map->capacity * 7) {
+                        int err = hash_map_reserve(map, map->count + 1);
+                        if (err) {
+                                return err;
+                        }
+                }
+                index = ds__hash_map_find_empty(map, hash);
+                ds__hash_map_set_ctrl(map, index, hash & 0x7f);
+                memcpy(ds__hash_map_slot(map, index), key, map->key_size);
+                DS__STATS_ADD(map, memcpy_bytes, map->key_size);
+                map->count++;
+        }
+
+        if (map->value_size > 0) {
+                memcpy(ds__hash_map_slot(map, index) + map->value_offset, 
+                       value, map->value_size);
+                DS__STATS_ADD(map, memcpy_bytes, map->value_size);
+        }
+        return DS_NO_ERROR;
+}
+
+// get the value of a key
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the key is not present
+int hash_map_get(struct hash_map_t *map, const void *key, void *value) {
+        if (map == NULL || key == NULL || 
+            (value == NULL && map->value_size > 0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int index = ds__hash_map_find_index(map, key, 
+                                            map->hash(key, map->key_size));
+        if (index < 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        if (map->value_size > 0) {
+                memcpy(value, ds__hash_map_slot(map, index) + 
+                              map->value_offset, map->value_size);
+                DS__STATS_ADD(map, memcpy_bytes, map->value_size);
+        }
+        return DS_NO_ERROR;
+}
+
+// get a pointer to the value of a key
+//
+// the pointer is valid until the next put, remove or reserve
+// returns NULL if the key is not present
+void *hash_map_find(struct hash_map_t *map, const void *key) {
+        if (map == NULL || key == NULL) {
+                return NULL;
+        }
+
+        int index = ds__hash_map_find_index(map, key, 
+                                            map->hash(key, map->key_size));
+        if (index < 0) {
+                return NULL;
+        }
+        return ds__hash_map_slot(map, index) + map->value_offset;
+}
+
+// remove a key
+//
+// the keys following it in the probe sequence are shifted back into the
+// hole, so no tombstone is left behind
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the key is not present
+int hash_map_remove(struct hash_map_t *map, const void *key) {
+        if (map == NULL || key == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int hole = ds__hash_map_find_index(map, key, 
+                                           map->hash(key, map->key_size));
+        if (hole < 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+
+        int mask = map->capacity - 1;
+        int next = (hole + 1) & mask;
+        while (map->ctrl[next] != DS__HASH_MAP_EMPTY) {
+                char *slot = ds__hash_map_slot(map, next);
+                int home = (int)(map->hash(slot, map->key_size) >> 7) & mask;
+                // move it if the hole is between its home and itself
+                if (((hole - home) & mask) < ((next - home) & mask)) {
+                        memcpy(ds__hash_map_slot(map, hole), slot, 
+                               map->slot_size);
+                        DS__STATS_ADD(map, memcpy_bytes, map->slot_size);
+                        ds__hash_map_set_ctrl(map, hole, map->ctrl[next]);
+                        hole = next;
+                }
+                next = (next + 1) & mask;
+        }
+        ds__hash_map_set_ctrl(map, hole, DS__HASH_MAP_EMPTY);
+        map->count--;
+
+        return DS_NO_ERROR;
+}
+
+// iterate over the items of the hash map
+//
+// start with *index = 0, every call moves *index past the returned item
+// key and value may be NULL, they point into the hash map
+// returns 0 if an item was returned
+// returns DS_RANGE_ERROR when there are no more items
+int hash_map_next(struct hash_map_t *map, int *index, void **key, 
+                  void **value) {
+        if (map == NULL || index == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        while (*index < map->capacity) {
+                int i = (*index)++;
+                if (map->ctrl[i] & DS__HASH_MAP_EMPTY) {
+                        continue;
+                }
+                if (key != NULL) {
+                        *key = ds__hash_map_slot(map, i);
+                }
+                if (value != NULL) {
+                        *value = ds__hash_map_slot(map, i) + 
+                                 map->value_offset;
+                }
+                return DS_NO_ERROR;
+        }
+        return DS_RANGE_ERROR;
+}
+
+// remove all the items of the hash map
+//
+// the capacity is kept
+// returns 0 if no error
+int hash_map_clear(struct hash_map_t *map) {
+        if (map == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (map->capacity > 0) {
+                memset(map->ctrl, DS__HASH_MAP_EMPTY, 
+                       map->capacity + DS_HASH_MAP_GROUP - 1);
+        }
+        map->count = 0;
+        return DS_NO_ERROR;
+}
+
+// delete the hash map
+//
+// frees the slots, set count and capacity to zero
+int hash_map_delete(struct hash_map_t *map) {
+        if (map == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (map->capacity > 0) {
+                DS__FREE(map, map->ctrl, 
+                        ds__hash_map_block_bytes(map, map->capacity));
+        }
+        map->ctrl = NULL;
+        map->slots = NULL;
+        map->count = 0;
+        map->capacity = 0;
+        return DS_NO_ERROR;
+}
+
+// get the counters of the hash map
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int hash_map_stats(struct hash_map_t *map, struct ds_stats_t *stats) {
+        if (map == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = map->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// node of a b-tree map, the keys start at DS__BTREE_KEYS_OFFSET, a leaf
+// then has its values at map->values_offset, an inner node has count + 1
+// child pointers at map->children_offset
+struct ds__btree_node_t {
+        struct ds__btree_node_t *prev;  // leaves only
+        struct ds__btree_node_t *next;  // leaves only
+        int count;                      // number of keys
+        int leaf;
+};
+
+#define DS__BTREE_KEYS_OFFSET \
+        ((sizeof(struct ds__btree_node_t) + 15) & ~(size_t)15)
+#define DS__BTREE_MIN_CAPACITY 4
+
+// initialize the b-tree map
+//
+// returns 0 if no error
+int btree_map_init(struct btree_map_t *map, int key_size, int value_size,
+                   int (*compare)(const void *a, const void *b)) {
+        return btree_map_init_alloc(map, key_size, value_size, compare, 
+                                    NULL);
+}
+
+// initialize the b-tree map with a custom allocator
+//
+// the node capacities are chosen so a node fits in DS_BTREE_NODE_SIZE
+// bytes, with at least DS__BTREE_MIN_CAPACITY keys for very big items
+// nothing is allocated until the first put
+// returns 0 if no error
+int btree_map_init_alloc(struct btree_map_t *map, int key_size, 
+                         int value_size,
+                         int (*compare)(const void *a, const void *b),
+                         const struct ds_allocator_t *allocator) {
+        if (map == NULL || key_size <= 0 || value_size < 0 || 
+            compare == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        size_t keys = DS__BTREE_KEYS_OFFSET;
+        size_t value_align = ds__align_of_size(value_size);
+        size_t pointer = sizeof(struct ds__btree_node_t *);
+        size_t room = DS_BTREE_NODE_SIZE > keys ? 
+                      DS_BTREE_NODE_SIZE - keys : 0;
+
+        size_t leaf_capacity = room / ((size_t)key_size + value_size);
+        for (;;) {
+                if (leaf_capacity < DS__BTREE_MIN_CAPACITY) {
+                        leaf_capacity = DS__BTREE_MIN_CAPACITY;
+                }
+                map->values_offset = (keys + leaf_capacity * key_size + 
+                                      value_align - 1) & -value_align;
+                map->leaf_size = map->values_offset + 
+                                 leaf_capacity * value_size;
+                if (map->leaf_size <= DS_BTREE_NODE_SIZE || 
+                    leaf_capacity == DS__BTREE_MIN_CAPACITY) {
+                        break;
+                }
+                leaf_capacity--;
+        }
+
+        size_t inner_capacity = room > pointer ? 
+                                (room - pointer) / (key_size + pointer) : 0;
+        for (;;) {
+                if (inner_capacity < DS__BTREE_MIN_CAPACITY) {
+                        inner_capacity = DS__BTREE_MIN_CAPACITY;
+                }
+                map->children_offset = (keys + inner_capacity * key_size + 
+                                        pointer - 1) & -pointer;
+                map->inner_size = map->children_offset + 
+                                  (inner_capacity + 1) * pointer;
+                if (map->inner_size <= DS_BTREE_NODE_SIZE || 
+                    inner_capacity == DS__BTREE_MIN_CAPACITY) {
+                        break;
+                }
+                inner_capacity--;
+        }
+
+        map->root = NULL;
+        map->key_size = key_size;
+        map->value_size = value_size;
+        map->leaf_capacity = (int)leaf_capacity;
+        map->inner_capacity = (int)inner_capacity;
+        map->count = 0;
+        map->compare = compare;
+        map->allocator = allocator;
+        DS__STATS_INIT(map);
+        return DS_NO_ERROR;
+}
+
+static char *ds__btree_key(const struct btree_map_t *map, 
+                           struct ds__btree_node_t *node, int index) {
+        return (char *)node + DS__BTREE_KEYS_OFFSET + 
+               (size_t)index * map->key_size;
+}
+
+static char *ds__btree_value(const struct btree_map_t *map, 
+                             struct ds__btree_node_t *node, int index) {
+        return (char *)node + map->values_offset + 
+               (size_t)index * map->value_size;
+}
+
+static struct ds__btree_node_t **ds__btree_children(
+                const struct btree_map_t *map, struct ds__btree_node_t *node) {
+        return (struct ds__btree_node_t **)((char *)node + 
+                                            map->children_offset);
+}
+
+static int ds__btree_capacity(const struct btree_map_t *map, 
+                              struct ds__btree_node_t *node) {
+        return node->leaf ? map->leaf_capacity : map->inner_capacity;
+}
+
+// fewest keys a node may keep once it is not the root
+static int ds__btree_min_count(const struct btree_map_t *map, 
+                               struct ds__btree_node_t *node) {
+        return node->leaf ? map->leaf_capacity / 2 : 
+                            (map->inner_capacity - 1) / 2;
+}
+
+static struct ds__btree_node_t *ds__btree_new_node(struct btree_map_t *map,
+                                                   int leaf) {
+        struct ds__btree_node_t *node = DS__ALLOC(map, leaf ? 
+                                                  map->leaf_size : 
+                                                  map->inner_size);
+        if (node == NULL) {
+                return NULL;
+        }
+        node->prev = NULL;
+        node->next = NULL;
+        node->count = 0;
+        node->leaf = leaf;
+        return node;
+}
+
+static void ds__btree_free_node(struct btree_map_t *map, 
+                                struct ds__btree_node_t *node) {
+        DS__FREE(map, node, node->leaf ? map->leaf_size : map->inner_size);
+}
+
+// free a node and everything under it
+static void ds__btree_free_tree(struct btree_map_t *map, 
+                                struct ds__btree_node_t *node) {
+        if (!node->leaf) {
+                struct ds__btree_node_t **children = 
+                        ds__btree_children(map, node);
+                for (int i = 0; i <= node->count; i++) {
+                        ds__btree_free_tree(map, children[i]);
+                }
+        }
+        ds__btree_free_node(map, node);
+}
+
+// index of the first key of the node that is >= key
+static int ds__btree_lower(const struct btree_map_t *map, 
+                           struct ds__btree_node_t *node, const void *key) {
+        int low = 0;
+        int high = node->count;
+        while (low < high) {
+                int middle = low + (high - low) / 2;
+                if (map->compare(ds__btree_key(map, node, middle), key) < 0) {
+                        low = middle + 1;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+// index of the first key of the node that is > key, which is also the
+// child of an inner node that covers key
+static int ds__btree_upper(const struct btree_map_t *map, 
+                           struct ds__btree_node_t *node, const void *key) {
+        int low = 0;
+        int high = node->count;
+        while (low < high) {
+                int middle = low + (high - low) / 2;
+                if (map->compare(ds__btree_key(map, node, middle), key) <= 0) {
+                        low = middle + 1;
+                } else {
+                        high = middle;
+                }
+        }
+        return low;
+}
+
+// move count keys (and values or children) of a node from index from to
+// index to, inside the same node or into another one
+// for inner nodes the child right of every key moves with it
+static void ds__btree_move(struct btree_map_t *map, 
+                           struct ds__btree_node_t *dst, int to,
+                           struct ds__btree_node_t *src, int from, 
+                           int count) {
+        if (count <= 0) {
+                return;
+        }
+        size_t bytes = (size_t)count * map->key_size;
+        memmove(ds__btree_key(map, dst, to), ds__btree_key(map, src, from),
+                bytes);
+        if (dst->leaf) {
+                size_t value_bytes = (size_t)count * map->value_size;
+                memmove(ds__btree_value(map, dst, to), 
+                        ds__btree_value(map, src, from), value_bytes);
+                bytes += value_bytes;
+        } else {
+                size_t child_bytes = (size_t)count * 
+                                     sizeof(struct ds__btree_node_t *);
+                memmove(ds__btree_children(map, dst) + to + 1, 
+                        ds__btree_children(map, src) + from + 1, 
+                        child_bytes);
+                bytes += child_bytes;
+        }
+        DS__STATS_ADD(map, memcpy_bytes, bytes);
+}
+
+// split the full child index of parent in two halves
+//
+// the parent must not be full
+// returns 0 if no error
+static int ds__btree_split_child(struct btree_map_t *map, 
+                                 struct ds__btree_node_t *parent, 
+                                 int index) {
+        struct ds__btree_node_t **children = ds__btree_children(map, parent);
+        struct ds__btree_node_t *left = children[index];
+        struct ds__btree_node_t *right = ds__btree_new_node(map, left->leaf);
+        if (right == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        DS__STATS_ADD(map, grows, 1);
+
+        int middle = left->count / 2;
+        ds__btree_move(map, parent, index + 1, parent, index, 
+                       parent->count - index);
+        if (left->leaf) {
+                // the first key of the right leaf is copied up
+                ds__btree_move(map, right, 0, left, middle, 
+                               left->count - middle);
+                right->count = left->count - middle;
+                right->prev = left;
+                right->next = left->next;
+                if (left->next != NULL) {
+                        left->next->prev = right;
+                }
+                left->next = right;
+                memcpy(ds__btree_key(map, parent, index), 
+                       ds__btree_key(map, right, 0), map->key_size);
+        } else {
+                // the middle key moves up
+                ds__btree_children(map, right)[0] = 
+                        ds__btree_children(map, left)[middle + 1];
+                ds__btree_move(map, right, 0, left, middle + 1, 
+                               left->count - middle - 1);
+                right->count = left->count - middle - 1;
+                memcpy(ds__btree_key(map, parent, index), 
+                       ds__btree_key(map, left, middle), map->key_size);
+        }
+        left->count = middle;
+        children[index + 1] = right;
+        parent->count++;
+        return DS_NO_ERROR;
+}
+
+// put a key and its value in the b-tree map
+//
+// the value of a key already present is overwritten
+// full nodes are split on the way down, so the insert never has to walk
+// back up the tree
+// returns 0 if no error
+int btree_map_put(struct btree_map_t *map, const void *key, 
+                  const void *value) {
+        if (map == NULL || key == NULL || 
+            (value == NULL && map->value_size > 0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (map->root == NULL) {
+                map->root = ds__btree_new_node(map, 1);
+                if (map->root == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+        }
+        if (map->root->count == ds__btree_capacity(map, map->root)) {
+                struct ds__btree_node_t *root = ds__btree_new_node(map, 0);
+                if (root == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                ds__btree_children(map, root)[0] = map->root;
+                if (ds__btree_split_child(map, root, 0) != DS_NO_ERROR) {
+                        ds__btree_free_node(map, root);
+                        return DS_MALLOC_ERROR;
+                }
+                map->root = root;
+        }
+
+        struct ds__btree_node_t *node = map->root;
+        while (!node->leaf) {
+                int index = ds__btree_upper(map, node, key);
+                struct ds__btree_node_t *child = 
+                        ds__btree_children(map, node)[index];
+                if (child->count == ds__btree_capacity(map, child)) {
+                        int err = ds__btree_split_child(map, node, index);
+                        if (err != DS_NO_ERROR) {
+                                return err;
+                        }
+                        if (map->compare(key, ds__btree_key(map, node, 
+                                                            index)) >= 0) {
+                                index++;
+                        }
+                        child = ds__btree_children(map, node)[index];
+                }
+                node = child;
+        }
+
+        int index = ds__btree_lower(map, node, key);
+        if (index == node->count || 
+            map->compare(ds__btree_key(map, node, index), key) != 0) {
+                if (map->count == INT_MAX) {
+                        return DS_FULL_ERROR;
+                }
+                ds__btree_move(map, node, index + 1, node, index, 
+                               node->count - index);
+                memcpy(ds__btree_key(map, node, index), key, map->key_size);
+                node->count++;
+                map->count++;
+        }
+        if (map->value_size > 0) {
+                memcpy(ds__btree_value(map, node, index), value, 
+                       map->value_size);
+        }
+        DS__STATS_ADD(map, memcpy_bytes, map->key_size + map->value_size);
+        return DS_NO_ERROR;
+}
+
+// leaf holding key if it is present, *index is set to its position
+static struct ds__btree_node_t *ds__btree_find(const struct btree_map_t *map,
+                                               const void *key, int *index) {
+        struct ds__btree_node_t *node = map->root;
+        if (node == NULL) {
+                return NULL;
+        }
+        while (!node->leaf) {
+                node = ds__btree_children(map, node)[ds__btree_upper(map, 
+                                                                    node, 
+                                                                    key)];
+        }
+        *index = ds__btree_lower(map, node, key);
+        if (*index == node->count || 
+            map->compare(ds__btree_key(map, node, *index), key) != 0) {
+                return NULL;
+        }
+        return node;
+}
+
+// get the value of a key
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the key is not present
+int btree_map_get(struct btree_map_t *map, const void *key, void *value) {
+        if (map == NULL || key == NULL || 
+            (value == NULL && map->value_size > 0)) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int index;
+        struct ds__btree_node_t *leaf = ds__btree_find(map, key, &index);
+        if (leaf == NULL) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        if (map->value_size > 0) {
+                memcpy(value, ds__btree_value(map, leaf, index), 
+                       map->value_size);
+                DS__STATS_ADD(map, memcpy_bytes, map->value_size);
+        }
+        return DS_NO_ERROR;
+}
+
+// get a pointer to the value of a key
+//
+// the pointer is valid until the next put or remove
+// returns NULL if the key is not present
+void *btree_map_find(struct btree_map_t *map, const void *key) {
+        if (map == NULL || key == NULL) {
+                return NULL;
+        }
+
+        int index;
+        struct ds__btree_node_t *leaf = ds__btree_find(map, key, &index);
+        if (leaf == NULL) {
+                return NULL;
+        }
+        return ds__btree_value(map, leaf, index);
+}
+
+// move the last key of the left sibling into child index of parent
+static void ds__btree_borrow_left(struct btree_map_t *map, 
+                                  struct ds__btree_node_t *parent, 
+                                  int index) {
+        struct ds__btree_node_t **children = ds__btree_children(map, parent);
+        struct ds__btree_node_t *left = children[index - 1];
+        struct ds__btree_node_t *child = children[index];
+        char *separator = ds__btree_key(map, parent, index - 1);
+
+        if (child->leaf) {
+                ds__btree_move(map, child, 1, child, 0, child->count);
+                ds__btree_move(map, child, 0, left, left->count - 1, 1);
+                memcpy(separator, ds__btree_key(map, child, 0), 
+                       map->key_size);
+        } else {
+                struct ds__btree_node_t **moved = 
+                        ds__btree_children(map, child);
+                ds__btree_move(map, child, 1, child, 0, child->count);
+                moved[1] = moved[0];
+                moved[0] = ds__btree_children(map, left)[left->count];
+                memcpy(ds__btree_key(map, child, 0), separator, 
+                       map->key_size);
+                memcpy(separator, ds__btree_key(map, left, left->count - 1),
+                       map->key_size);
+        }
+        left->count--;
+        child->count++;
+}
+
+// move the first key of the right sibling into child index of parent
+static void ds__btree_borrow_right(struct btree_map_t *map, 
+                                   struct ds__btree_node_t *parent, 
+                                   int index) {
+        struct ds__btree_node_t **children = ds__btree_children(map, parent);
+        struct ds__btree_node_t *child = children[index];
+        struct ds__btree_node_t *right = children[index + 1];
+        char *separator = ds__btree_key(map, parent, index);
+
+        if (child->leaf) {
+                ds__btree_move(map, child, child->count, right, 0, 1);
+                ds__btree_move(map, right, 0, right, 1, right->count - 1);
+                memcpy(separator, ds__btree_key(map, right, 0), 
+                       map->key_size);
+        } else {
+                struct ds__btree_node_t **moved = 
+                        ds__btree_children(map, right);
+                memcpy(ds__btree_key(map, child, child->count), separator, 
+                       map->key_size);
+                ds__btree_children(map, child)[child->count + 1] = moved[0];
+                memcpy(separator, ds__btree_key(map, right, 0), 
+                       map->key_size);
+                moved[0] = moved[1];
+                ds__btree_move(map, right, 0, right, 1, right->count - 1);
+        }
+        right->count--;
+        child->count++;
+}
+
+// merge child index + 1 of parent into child index and free it
+static void ds__btree_merge(struct btree_map_t *map, 
+                            struct ds__btree_node_t *parent, int index) {
+        struct ds__btree_node_t **children = ds__btree_children(map, parent);
+        struct ds__btree_node_t *left = children[index];
+        struct ds__btree_node_t *right = children[index + 1];
+
+        if (left->leaf) {
+                ds__btree_move(map, left, left->count, right, 0, 
+                               right->count);
+                left->count += right->count;
+                left->next = right->next;
+                if (right->next != NULL) {
+                        right->next->prev = left;
+                }
+        } else {
+                // the separator comes down between the two halves
+                memcpy(ds__btree_key(map, left, left->count), 
+                       ds__btree_key(map, parent, index), map->key_size);
+                ds__btree_children(map, left)[left->count + 1] = 
+                        ds__btree_children(map, right)[0];
+                ds__btree_move(map, left, left->count + 1, right, 0, 
+                               right->count);
+                left->count += right->count + 1;
+        }
+        ds__btree_move(map, parent, index, parent, index + 1, 
+                       parent->count - index - 1);
+        parent->count--;
+        ds__btree_free_node(map, right);
+}
+
+// make sure child index of parent can lose a key, by borrowing one from
+// a sibling or merging with it
+//
+// returns the index of the child that now covers the same keys
+static int ds__btree_fix_child(struct btree_map_t *map, 
+                               struct ds__btree_node_t *parent, int index) {
+        struct ds__btree_node_t **children = ds__btree_children(map, parent);
+        struct ds__btree_node_t *left = index > 0 ? children[index - 1] : 
+                                                    NULL;
+        struct ds__btree_node_t *right = index < parent->count ? 
+                                         children[index + 1] : NULL;
+
+        if (left != NULL && left->count > ds__btree_min_count(map, left)) {
+                ds__btree_borrow_left(map, parent, index);
+                return index;
+        }
+        if (right != NULL && right->count > ds__btree_min_count(map, right)) {
+                ds__btree_borrow_right(map, parent, index);
+                return index;
+        }
+        if (right != NULL) {
+                ds__btree_merge(map, parent, index);
+                return index;
+        }
+        ds__btree_merge(map, parent, index - 1);
+        return index - 1;
+}
+
+// remove a key
+//
+// nodes about to become too small are refilled on the way down, so the
+// remove never has to walk back up the tree
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the key is not present
+int btree_map_remove(struct btree_map_t *map, const void *key) {
+        if (map == NULL || key == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (map->root == NULL) {
+                return DS_NOT_FOUND_ERROR;
+        }
+
+        struct ds__btree_node_t *node = map->root;
+        while (!node->leaf) {
+                int index = ds__btree_upper(map, node, key);
+                struct ds__btree_node_t *child = 
+                        ds__btree_children(map, node)[index];
+                if (child->count <= ds__btree_min_count(map, child)) {
+                        index = ds__btree_fix_child(map, node, index);
+                        child = ds__btree_children(map, node)[index];
+                }
+                if (node->count == 0) {
+                        // only the root can run out of keys
+                        ds__btree_free_node(map, node);
+                        map->root = child;
+                }
+                node = child;
+        }
+
+        int index = ds__btree_lower(map, node, key);
+        if (index == node->count || 
+            map->compare(ds__btree_key(map, node, index), key) != 0) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        ds__btree_move(map, node, index, node, index + 1, 
+                       node->count - index - 1);
+        node->count--;
+        map->count--;
+        if (map->count == 0) {
+                ds__btree_free_node(map, node);
+                map->root = NULL;
+        }
+        return DS_NO_ERROR;
+}
+
+// point the iterator at index of leaf and return that entry
+static int ds__btree_iterator_set(struct btree_iterator_t *iterator, 
+                                  struct ds__btree_node_t *leaf, int index,
+                                  void **key, void **value) {
+        iterator->leaf = leaf;
+        iterator->index = index;
+        if (leaf == NULL) {
+                return DS_RANGE_ERROR;
+        }
+        if (key != NULL) {
+                *key = ds__btree_key(iterator->map, leaf, index);
+        }
+        if (value != NULL) {
+                *value = ds__btree_value(iterator->map, leaf, index);
+        }
+        return DS_NO_ERROR;
+}
+
+// point the iterator at the smallest key
+//
+// key and value may be NULL, they point into the b-tree map
+// returns 0 if no error
+// returns DS_RANGE_ERROR if the map is empty
+int btree_map_first(const struct btree_map_t *map, 
+                    struct btree_iterator_t *iterator, void **key, 
+                    void **value) {
+        if (map == NULL || iterator == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        struct ds__btree_node_t *node = map->root;
+        while (node != NULL && !node->leaf) {
+                node = ds__btree_children(map, node)[0];
+        }
+        iterator->map = map;
+        return ds__btree_iterator_set(iterator, node, 0, key, value);
+}
+
+// point the iterator at the largest key
+//
+// key and value may be NULL, they point into the b-tree map
+// returns 0 if no error
+// returns DS_RANGE_ERROR if the map is empty
+int btree_map_last(const struct btree_map_t *map, 
+                   struct btree_iterator_t *iterator, void **key, 
+                   void **value) {
+        if (map == NULL || iterator == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        struct ds__btree_node_t *node = map->root;
+        while (node != NULL && !node->leaf) {
+                node = ds__btree_children(map, node)[node->count];
+        }
+        iterator->map = map;
+        return ds__btree_iterator_set(iterator, node, 
+                                      node ? node->count - 1 : 0, key, 
+                                      value);
+}
+
+// point the iterator at the smallest key that is >= key
+//
+// this is where a range scan starts, continue it with btree_map_next
+// found_key and value may be NULL, they point into the b-tree map
+// returns 0 if no error
+// returns DS_RANGE_ERROR if every key is smaller
+int btree_map_lower_bound(const struct btree_map_t *map, const void *key,
+                          struct btree_iterator_t *iterator, 
+                          void **found_key, void **value) {
+        if (map == NULL || key == NULL || iterator == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        iterator->map = map;
+        struct ds__btree_node_t *node = map->root;
+        if (node == NULL) {
+                return ds__btree_iterator_set(iterator, NULL, 0, found_key,
+                                              value);
+        }
+        while (!node->leaf) {
+                node = ds__btree_children(map, node)[ds__btree_upper(map, 
+                                                                    node, 
+                                                                    key)];
+        }
+        int index = ds__btree_lower(map, node, key);
+        if (index == node->count) {
+                node = node->next;
+                index = 0;
+        }
+        return ds__btree_iterator_set(iterator, node, index, found_key, 
+                                      value);
+}
+
+// move the iterator to the next key in order
+//
+// key and value may be NULL, they point into the b-tree map
+// returns 0 if no error
+// returns DS_RANGE_ERROR when there are no more keys
+int btree_map_next(struct btree_iterator_t *iterator, void **key, 
+                   void **value) {
+        if (iterator == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (iterator->leaf == NULL) {
+                return DS_RANGE_ERROR;
+        }
+
+        struct ds__btree_node_t *leaf = iterator->leaf;
+        int index = iterator->index + 1;
+        if (index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+        }
+        return ds__btree_iterator_set(iterator, leaf, index, key, value);
+}
+
+// move the iterator to the previous key in order
+//
+// key and value may be NULL, they point into the b-tree map
+// returns 0 if no error
+// returns DS_RANGE_ERROR when there are no more keys
+int btree_map_prev(struct btree_iterator_t *iterator, void **key, 
+                   void **value) {
+        if (iterator == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (iterator->leaf == NULL) {
+                return DS_RANGE_ERROR;
+        }
+
+        struct ds__btree_node_t *leaf = iterator->leaf;
+        int index = iterator->index - 1;
+        if (index < 0) {
+                leaf = leaf->prev;
+                index = leaf ? leaf->count - 1 : 0;
+        }
+        return ds__btree_iterator_set(iterator, leaf, index, key, value);
+}
+
+// build the b-tree map from count sorted keys and their values
+//
+// the map must be empty and the keys strictly increasing
+// the leaves and inner nodes are filled bottom up and evenly, which is
+// much faster than count puts and leaves every node nearly full
+// values may be NULL when value_size is 0
+// returns 0 if no error
+int btree_map_bulk_load(struct btree_map_t *map, const void *keys,
+                        const void *values, int count) {
+        if (map == NULL || count < 0 || (count > 0 && keys == NULL) || 
+            (count > 0 && values == NULL && map->value_size > 0) || 
+            map->root != NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        const char *key = keys;
+        for (int i = 1; i < count; i++) {
+                if (map->compare(key + (size_t)(i - 1) * map->key_size, 
+                                 key + (size_t)i * map->key_size) >= 0) {
+                        return DS_ARGUMENT_ERROR;
+                }
+        }
+        if (count == 0) {
+                return DS_NO_ERROR;
+        }
+
+        // the nodes of the level being built and their smallest keys
+        int level = (count + map->leaf_capacity - 1) / map->leaf_capacity;
+        size_t array_size = (size_t)level * (sizeof(void *) * 2);
+        struct ds__btree_node_t **nodes = DS__ALLOC(map, array_size);
+        if (nodes == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        const char **mins = (const char **)(nodes + level);
+
+        const char *value = values;
+        int start = 0;
+        for (int i = 0; i < level; i++) {
+                int n = count / level + (i < count % level);
+                struct ds__btree_node_t *leaf = ds__btree_new_node(map, 1);
+                if (leaf == NULL) {
+                        for (int j = 0; j < i; j++) {
+                                ds__btree_free_node(map, nodes[j]);
+                        }
+                        DS__FREE(map, nodes, array_size);
+                        return DS_MALLOC_ERROR;
+                }
+                memcpy(ds__btree_key(map, leaf, 0), 
+                       key + (size_t)start * map->key_size, 
+                       (size_t)n * map->key_size);
+                if (map->value_size > 0) {
+                        memcpy(ds__btree_value(map, leaf, 0), 
+                               value + (size_t)start * map->value_size, 
+                               (size_t)n * map->value_size);
+                }
+                DS__STATS_ADD(map, memcpy_bytes, 
+                              (size_t)n * (map->key_size + map->value_size));
+                leaf->count = n;
+                if (i > 0) {
+                        leaf->prev = nodes[i - 1];
+                        nodes[i - 1]->next = leaf;
+                }
+                nodes[i] = leaf;
+                mins[i] = ds__btree_key(map, leaf, 0);
+                start += n;
+        }
+
+        // each inner level groups the nodes of the level below it, node
+        // g of the new level never overwrites a node not yet grouped
+        int fanout = map->inner_capacity + 1;
+        while (level > 1) {
+                int groups = (level + fanout - 1) / fanout;
+                start = 0;
+                for (int g = 0; g < groups; g++) {
+                        int n = level / groups + (g < level % groups);
+                        struct ds__btree_node_t *node = 
+                                ds__btree_new_node(map, 0);
+                        if (node == NULL) {
+                                for (int j = 0; j < g; j++) {
+                                        ds__btree_free_tree(map, nodes[j]);
+                                }
+                                for (int j = start; j < level; j++) {
+                                        ds__btree_free_tree(map, nodes[j]);
+                                }
+                                DS__FREE(map, nodes, array_size);
+                                return DS_MALLOC_ERROR;
+                        }
+                        struct ds__btree_node_t **children = 
+                                ds__btree_children(map, node);
+                        for (int i = 0; i < n; i++) {
+                                children[i] = nodes[start + i];
+                                if (i > 0) {
+                                        memcpy(ds__btree_key(map, node, 
+                                                             i - 1), 
+                                               mins[start + i], 
+                                               map->key_size);
+                                }
+                        }
+                        node->count = n - 1;
+                        nodes[g] = node;
+                        mins[g] = mins[start];
+                        start += n;
+                }
+                level = groups;
+        }
+
+        map->root = nodes[0];
+        map->count = count;
+        DS__FREE(map, nodes, array_size);
+        return DS_NO_ERROR;
+}
+
+// remove all the items of the b-tree map
+//
+// frees every node
+// returns 0 if no error
+int btree_map_clear(struct btree_map_t *map) {
+        if (map == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (map->root != NULL) {
+                ds__btree_free_tree(map, map->root);
+        }
+        map->root = NULL;
+        map->count = 0;
+        return DS_NO_ERROR;
+}
+
+// delete the b-tree map
+//
+// frees every node
+int btree_map_delete(struct btree_map_t *map) {
+        return btree_map_clear(map);
+}
+
+// get the counters of the b-tree map
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int btree_map_stats(struct btree_map_t *map, struct ds_stats_t *stats) {
+        if (map == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = map->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// byte scanning kernels
+//
+// ds__find_byte and ds__count_byte pick the widest implementation the
+// cpu supports: avx2, then sse2, then a portable scalar loop
+// the cpu is asked once, the answer is cached with relaxed atomics so
+// threads racing on the first call are fine (they all store the same)
+#if defined(__GNUC__) && defined(__x86_64__)
+#define DS__X86_DISPATCH
+#endif
+
+#ifdef DS__X86_DISPATCH
+static int ds__cpu_has_avx2(void) {
+        static int has_avx2 = -1;
+        int has = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+        if (has < 0) {
+                __builtin_cpu_init();
+                has = __builtin_cpu_supports("avx2") != 0;
+                __atomic_store_n(&has_avx2, has, __ATOMIC_RELAXED);
+        }
+        return has;
+}
+#endif
+
+static size_t ds__find_byte_scalar(const char *p, size_t n, char c) {
+        const char *found = memchr(p, c, n);
+        return found ? (size_t)(found - p) : n;
+}
+
+static size_t ds__count_byte_scalar(const char *p, size_t n, char c) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+                count += p[i] == c;
+        }
+        return count;
+}
+
+#if defined(__SSE2__)
+static size_t ds__find_byte_sse2(const char *p, size_t n, char c) {
+        __m128i needle = _mm_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+                __m128i block = _mm_loadu_si128((const __m128i *)(p + i));
+                unsigned mask = (unsigned)_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(block, needle));
+                if (mask) {
+                        return i + ds__ctz(mask);
+                }
+        }
+        return i + ds__find_byte_scalar(p + i, n - i, c);
+}
+
+static size_t ds__count_byte_sse2(const char *p, size_t n, char c) {
+        __m128i needle = _mm_set1_epi8(c);
+        size_t count = 0;
+        size_t i = 0;
+        while (i + 16 <= n) {
+                // byte counters overflow after 255 blocks, sum them before
+                __m128i counters = _mm_setzero_si128();
+                for (int k = 0; k < 255 && i + 16 <= n; k++, i += 16) {
+                        __m128i block = 
+                                _mm_loadu_si128((const __m128i *)(p + i));
+                        counters = _mm_sub_epi8(counters, 
+                                                _mm_cmpeq_epi8(block, needle));
+                }
+                __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+                count += (size_t)_mm_cvtsi128_si32(sums) + 
+                         (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+        return count + ds__count_byte_scalar(p + i, n - i, c);
+}
+#endif
+
+#ifdef DS__X86_DISPATCH
+__attribute__((target("avx2")))
+static size_t ds__find_byte_avx2(const char *p, size_t n, char c) {
+        __m256i needle = _mm256_set1_epi8(c);
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+                __m256i block = _mm256_loadu_si256((const __m256i *)(p + i));
+                unsigned mask = (unsigned)_mm256_movemask_epi8(
+                        _mm256_cmpeq_epi8(block, needle));
+                if (mask) {
+                        return i + ds__ctz(mask);
+                }
+        }
+        return i + ds__find_byte_scalar(p + i, n - i, c);
+}
+
+__attribute__((target("avx2")))
+static size_t ds__count_byte_avx2(const char *p, size_t n, char c) {
+        __m256i needle = _mm256_set1_epi8(c);
+        size_t count = 0;
+        size_t i = 0;
+        while (i + 32 <= n) {
+                __m256i counters = _mm256_setzero_si256();
+                for (int k = 0; k < 255 && i + 32 <= n; k++, i += 32) {
+                        __m256i block = 
+                                _mm256_loadu_si256((const __m256i *)(p + i));
+                        counters = _mm256_sub_epi8(
+                                counters, _mm256_cmpeq_epi8(block, needle));
+                }
+                __m256i sums = _mm256_sad_epu8(counters, 
+                                               _mm256_setzero_si256());
+                count += (size_t)_mm256_extract_epi64(sums, 0) + 
+                         (size_t)_mm256_extract_epi64(sums, 1) +
+                         (size_t)_mm256_extract_epi64(sums, 2) +
+                         (size_t)_mm256_extract_epi64(sums, 3);
+        }
+        return count + ds__count_byte_scalar(p + i, n - i, c);
+}
+#endif
+
+// offset of the first c in the n bytes at p, or n if there is none
+static size_t ds__find_byte(const char *p, size_t n, char c) {
+#ifdef DS__X86_DISPATCH
+        if (ds__cpu_has_avx2()) {
+                return ds__find_byte_avx2(p, n, c);
+        }
+#endif
+#if defined(__SSE2__)
+        return ds__find_byte_sse2(p, n, c);
+#else
+        return ds__find_byte_scalar(p, n, c);
+#endif
+}
+
+// number of c in the n bytes at p
+static size_t ds__count_byte(const char *p, size_t n, char c) {
+#ifdef DS__X86_DISPATCH
+        if (ds__cpu_has_avx2()) {
+                return ds__count_byte_avx2(p, n, c);
+        }
+#endif
+#if defined(__SSE2__)
+        return ds__count_byte_sse2(p, n, c);
+#else
+        return ds__count_byte_scalar(p, n, c);
+#endif
+}
+
+// offset of the first needle in the n bytes at p, or n if there is none
+//
+// candidates are found with ds__find_byte on the first character
+static size_t ds__find_bytes(const char *p, size_t n, const char *needle,
+                             size_t needle_len) {
+        if (needle_len == 0) {
+                return 0;
+        }
+        if (needle_len > n) {
+                return n;
+        }
+
+        size_t last = n - needle_len;
+        size_t i = 0;
+        while (i <= last) {
+                i += ds__find_byte(p + i, last - i + 1, needle[0]);
+                if (i > last) {
+                        break;
+                }
+                if (memcmp(p + i + 1, needle + 1, needle_len - 1) == 0) {
+                        return i;
+                }
+                i++;
+        }
+        return n;
+}
+
+// initialize a string builder
+//
+// keeps count, capacity as 0 and chars as NULL
+// returns 0 if no error
+int string_builder_init(struct string_builder_t *sb) {
+        return string_builder_init_alloc(sb, NULL);
+}
+
+// initialize a string builder with a custom allocator
+//
+// allocator NULL means malloc and free
+// returns 0 if no error
+int string_builder_init_alloc(struct string_builder_t *sb,
+                              const struct ds_allocator_t *allocator) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        sb->chars = NULL;
+        sb->count = 0;
+        sb->capacity = DS_STRING_BUILDER_INLINE;
+        sb->allocator = allocator;
+        DS__STATS_INIT(sb);
+        return DS_NO_ERROR;
+}
+
+// the storage currently in use, heap or inline
+static char *ds__string_builder_chars(struct string_builder_t *sb) {
+        return sb->chars ? sb->chars : sb->inline_chars;
+}
+
+// make room for extra more characters
+//
+// one more character is always kept free for the null terminator
+// the capacity doubles until it is enough
+// returns 0 if no error
+static int ds__string_builder_reserve(struct string_builder_t *sb, 
+                                      int extra) {
+        if (extra < 0 || sb->count > INT_MAX - 1 - extra) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int needed = sb->count + extra + 1;
+        if (needed <= sb->capacity) {
+                return DS_NO_ERROR;
+        }
+
+        size_t new_capacity = sb->capacity < 16 ? 16 : sb->capacity;
+        while (new_capacity < (size_t)needed) {
+                new_capacity *= 2;
+        }
+        if (new_capacity > INT_MAX) {
+                new_capacity = INT_MAX;
+        }
+
+        char *temp;
+        if (sb->chars == NULL) {
+                // spill the inline buffer to the heap
+                temp = DS__ALLOC(sb, new_capacity);
+                if (temp != NULL) {
+                        memcpy(temp, sb->inline_chars, sb->count);
+                }
+        } else {
+                temp = DS__REALLOC(sb, sb->chars, sb->capacity, 
+                                   new_capacity);
+        }
+        if (temp == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        DS__STATS_ADD(sb, grows, 1);
+        sb->chars = temp;
+        sb->capacity = (int)new_capacity;
+        return DS_NO_ERROR;
+}
+
+// append a formated string like printf
+//
+// formats directly into the spare capacity of the string builder, only
+// when the result does not fit the storage is grown and it is formatted
+// a second time
+// returns 0 if nothing went wrong while appending the string
+int string_builder_appendf(struct string_builder_t *sb, const char *format,
+                          ...) {
+        if (sb == NULL || format == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        // there is always at least one spare byte for the terminator
+        int spare = sb->capacity - sb->count;
+        va_list args;
+        va_start(args, format);
+        int needed = vsnprintf(ds__string_builder_chars(sb) + sb->count, 
+                               spare, format, args);
+        va_end(args);
+        if (needed < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (needed >= spare) {
+                int err = ds__string_builder_reserve(sb, needed);
+                if (err) {
+                        return err;
+                }
+
+                va_start(args, format);
+                vsnprintf(ds__string_builder_chars(sb) + sb->count, 
+                          needed + 1, format, args);
+                va_end(args);
+        }
+        sb->count += needed;
+        DS__STATS_ADD(sb, memcpy_bytes, needed);
+
+        return DS_NO_ERROR;
+}
+
+static const char ds__digit_pairs[201] = 
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+// number of decimal digits of value
+static int ds__count_digits(uint64_t value) {
+        int digits = 1;
+        for (;;) {
+                if (value < 10) return digits;
+                if (value < 100) return digits + 1;
+                if (value < 1000) return digits + 2;
+                if (value < 10000) return digits + 3;
+                value /= 10000;
+                digits += 4;
+        }
+}
+
+// write the decimal digits of value so that they end right before end
+//
+// the digits are written two at a time, back to front
+static void ds__write_decimal(char *end, uint64_t value) {
+        char *at = end;
+        while (value >= 100) {
+                int pair = (int)(value % 100) * 2;
+                value /= 100;
+                *--at = ds__digit_pairs[pair + 1];
+                *--at = ds__digit_pairs[pair];
+        }
+        if (value >= 10) {
+                *--at = ds__digit_pairs[value * 2 + 1];
+                *--at = ds__digit_pairs[value * 2];
+        } else {
+                *--at = (char)('0' + value);
+        }
+}
+
+// append value in decimal, with a leading minus if negative is set
+//
+// the digits are written straight into the storage, two at a time
+static int ds__string_builder_append_decimal(struct string_builder_t *sb,
+                                             uint64_t value, int negative) {
+        int digits = ds__count_digits(value);
+        int err = ds__string_builder_reserve(sb, digits + negative);
+        if (err) {
+                return err;
+        }
+
+        char *chars = ds__string_builder_chars(sb) + sb->count;
+        if (negative) {
+                *chars++ = '-';
+        }
+        ds__write_decimal(chars + digits, value);
+
+        sb->count += digits + negative;
+        DS__STATS_ADD(sb, memcpy_bytes, digits + negative);
+        return DS_NO_ERROR;
+}
+
+// append an int in decimal
+//
+// returns 0 if nothing went wrong
+int string_builder_append_int(struct string_builder_t *sb, int value) {
+        return string_builder_append_i64(sb, value);
+}
+
+// append an unsigned int in decimal
+//
+// returns 0 if nothing went wrong
+int string_builder_append_uint(struct string_builder_t *sb, 
+                               unsigned int value) {
+        return string_builder_append_u64(sb, value);
+}
+
+// append a 64 bit int in decimal
+//
+// returns 0 if nothing went wrong
+int string_builder_append_i64(struct string_builder_t *sb, int64_t value) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (value < 0) {
+                // negate as unsigned so INT64_MIN does not overflow
+                return ds__string_builder_append_decimal(
+                        sb, 0 - (uint64_t)value, 1);
+        }
+        return ds__string_builder_append_decimal(sb, value, 0);
+}
+
+// append a 64 bit unsigned int in decimal
+//
+// returns 0 if nothing went wrong
+int string_builder_append_u64(struct string_builder_t *sb, uint64_t value) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        return ds__string_builder_append_decimal(sb, value, 0);
+}
+
+// append a 64 bit unsigned int in lowercase hexadecimal, without prefix
+//
+// returns 0 if nothing went wrong
+int string_builder_append_hex(struct string_builder_t *sb, uint64_t value) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int digits = 1;
+        while (digits < 16 && (value >> (4 * digits)) != 0) {
+                digits++;
+        }
+        int err = ds__string_builder_reserve(sb, digits);
+        if (err) {
+                return err;
+        }
+
+        char *at = ds__string_builder_chars(sb) + sb->count + digits;
+        for (int i = 0; i < digits; i++, value >>= 4) {
+                *--at = "0123456789abcdef"[value & 0xf];
+        }
+        sb->count += digits;
+        DS__STATS_ADD(sb, memcpy_bytes, digits);
+        return DS_NO_ERROR;
+}
+
+// significands of the powers of ten for shortest double formatting
+//
+// entry k is floor(10^k / 2^e) + 1 for k in [-292, 324], with e chosen
+// so it fits in exactly 128 bits (high, low)
+#define DS__POW10_MIN_EXPONENT (-292)
+
+static const uint64_t ds__pow10_significands[617][2] = {
+        { 0xFF77B1FCBEBCDC4F, 0x25E8E89C13BB0F7B }, // -292
+        { 0x9FAACF3DF73609B1, 0x77B191618C54E9AD }, // -291
+        { 0xC795830D75038C1D, 0xD59DF5B9EF6A2418 }, // -290
+        { 0xF97AE3D0D2446F25, 0x4B0573286B44AD1E }, // -289
+        { 0x9BECCE62836AC577, 0x4EE367F9430AEC33 }, // -288
+        { 0xC2E801FB244576D5, 0x229C41F793CDA740 }, // -287
+        { 0xF3A20279ED56D48A, 0x6B43527578C11110 }, // -286
+        { 0x9845418C345644D6, 0x830A13896B78AAAA }, // -285
+        { 0xBE5691EF416BD60C, 0x23CC986BC656D554 }, // -284
+        { 0xEDEC366B11C6CB8F, 0x2CBFBE86B7EC8AA9 }, // -283
+        { 0x94B3A202EB1C3F39, 0x7BF7D71432F3D6AA }, // -282
+        { 0xB9E08A83A5E34F07, 0xDAF5CCD93FB0CC54 }, // -281
+        { 0xE858AD248F5C22C9, 0xD1B3400F8F9CFF69 }, // -280
+        { 0x91376C36D99995BE, 0x23100809B9C21FA2 }, // -279
+        { 0xB58547448FFFFB2D, 0xABD40A0C2832A78B }, // -278
+        { 0xE2E69915B3FFF9F9, 0x16C90C8F323F516D }, // -277
+        { 0x8DD01FAD907FFC3B, 0xAE3DA7D97F6792E4 }, // -276
+        { 0xB1442798F49FFB4A, 0x99CD11CFDF41779D }, // -275
+        { 0xDD95317F31C7FA1D, 0x40405643D711D584 }, // -274
+        { 0x8A7D3EEF7F1CFC52, 0x482835EA666B2573 }, // -273
+        { 0xAD1C8EAB5EE43B66, 0xDA3243650005EED0 }, // -272
+        { 0xD863B256369D4A40, 0x90BED43E40076A83 }, // -271
+        { 0x873E4F75E2224E68, 0x5A7744A6E804A292 }, // -270
+        { 0xA90DE3535AAAE202, 0x711515D0A205CB37 }, // -269
+        { 0xD3515C2831559A83, 0x0D5A5B44CA873E04 }, // -268
+        { 0x8412D9991ED58091, 0xE858790AFE9486C3 }, // -267
+        { 0xA5178FFF668AE0B6, 0x626E974DBE39A873 }, // -266
+        { 0xCE5D73FF402D98E3, 0xFB0A3D212DC81290 }, // -265
+        { 0x80FA687F881C7F8E, 0x7CE66634BC9D0B9A }, // -264
+        { 0xA139029F6A239F72, 0x1C1FFFC1EBC44E81 }, // -263
+        { 0xC987434744AC874E, 0xA327FFB266B56221 }, // -262
+        { 0xFBE9141915D7A922, 0x4BF1FF9F0062BAA9 }, // -261
+        { 0x9D71AC8FADA6C9B5, 0x6F773FC3603DB4AA }, // -260
+        { 0xC4CE17B399107C22, 0xCB550FB4384D21D4 }, // -259
+        { 0xF6019DA07F549B2B, 0x7E2A53A146606A49 }, // -258
+        { 0x99C102844F94E0FB, 0x2EDA7444CBFC426E }, // -257
+        { 0xC0314325637A1939, 0xFA911155FEFB5309 }, // -256
+        { 0xF03D93EEBC589F88, 0x793555AB7EBA27CB }, // -255
+        { 0x96267C7535B763B5, 0x4BC1558B2F3458DF }, // -254
+        { 0xBBB01B9283253CA2, 0x9EB1AAEDFB016F17 }, // -253
+        { 0xEA9C227723EE8BCB, 0x465E15A979C1CADD }, // -252
+        { 0x92A1958A7675175F, 0x0BFACD89EC191ECA }, // -251
+        { 0xB749FAED14125D36, 0xCEF980EC671F667C }, // -250
+        { 0xE51C79A85916F484, 0x82B7E12780E7401B }, // -249
+        { 0x8F31CC0937AE58D2, 0xD1B2ECB8B0908811 }, // -248
+        { 0xB2FE3F0B8599EF07, 0x861FA7E6DCB4AA16 }, // -247
+        { 0xDFBDCECE67006AC9, 0x67A791E093E1D49B }, // -246
+        { 0x8BD6A141006042BD, 0xE0C8BB2C5C6D24E1 }, // -245
+        { 0xAECC49914078536D, 0x58FAE9F773886E19 }, // -244
+        { 0xDA7F5BF590966848, 0xAF39A475506A899F }, // -243
+        { 0x888F99797A5E012D, 0x6D8406C952429604 }, // -242
+        { 0xAAB37FD7D8F58178, 0xC8E5087BA6D33B84 }, // -241
+        { 0xD5605FCDCF32E1D6, 0xFB1E4A9A90880A65 }, // -240
+        { 0x855C3BE0A17FCD26, 0x5CF2EEA09A550680 }, // -239
+        { 0xA6B34AD8C9DFC06F, 0xF42FAA48C0EA481F }, // -238
+        { 0xD0601D8EFC57B08B, 0xF13B94DAF124DA27 }, // -237
+        { 0x823C12795DB6CE57, 0x76C53D08D6B70859 }, // -236
+        { 0xA2CB1717B52481ED, 0x54768C4B0C64CA6F }, // -235
+        { 0xCB7DDCDDA26DA268, 0xA9942F5DCF7DFD0A }, // -234
+        { 0xFE5D54150B090B02, 0xD3F93B35435D7C4D }, // -233
+        { 0x9EFA548D26E5A6E1, 0xC47BC5014A1A6DB0 }, // -232
+        { 0xC6B8E9B0709F109A, 0x359AB6419CA1091C }, // -231
+        { 0xF867241C8CC6D4C0, 0xC30163D203C94B63 }, // -230
+        { 0x9B407691D7FC44F8, 0x79E0DE63425DCF1E }, // -229
+        { 0xC21094364DFB5636, 0x985915FC12F542E5 }, // -228
+        { 0xF294B943E17A2BC4, 0x3E6F5B7B17B2939E }, // -227
+        { 0x979CF3CA6CEC5B5A, 0xA705992CEECF9C43 }, // -226
+        { 0xBD8430BD08277231, 0x50C6FF782A838354 }, // -225
+        { 0xECE53CEC4A314EBD, 0xA4F8BF5635246429 }, // -224
+        { 0x940F4613AE5ED136, 0x871B7795E136BE9A }, // -223
+        { 0xB913179899F68584, 0x28E2557B59846E40 }, // -222
+        { 0xE757DD7EC07426E5, 0x331AEADA2FE589D0 }, // -221
+        { 0x9096EA6F3848984F, 0x3FF0D2C85DEF7622 }, // -220
+        { 0xB4BCA50B065ABE63, 0x0FED077A756B53AA }, // -219
+        { 0xE1EBCE4DC7F16DFB, 0xD3E8495912C62895 }, // -218
+        { 0x8D3360F09CF6E4BD, 0x64712DD7ABBBD95D }, // -217
+        { 0xB080392CC4349DEC, 0xBD8D794D96AACFB4 }, // -216
+        { 0xDCA04777F541C567, 0xECF0D7A0FC5583A1 }, // -215
+        { 0x89E42CAAF9491B60, 0xF41686C49DB57245 }, // -214
+        { 0xAC5D37D5B79B6239, 0x311C2875C522CED6 }, // -213
+        { 0xD77485CB25823AC7, 0x7D633293366B828C }, // -212
+        { 0x86A8D39EF77164BC, 0xAE5DFF9C02033198 }, // -211
+        { 0xA8530886B54DBDEB, 0xD9F57F830283FDFD }, // -210
+        { 0xD267CAA862A12D66, 0xD072DF63C324FD7C }, // -209
+        { 0x8380DEA93DA4BC60, 0x4247CB9E59F71E6E }, // -208
+        { 0xA46116538D0DEB78, 0x52D9BE85F074E609 }, // -207
+        { 0xCD795BE870516656, 0x67902E276C921F8C }, // -206
+        { 0x806BD9714632DFF6, 0x00BA1CD8A3DB53B7 }, // -205
+        { 0xA086CFCD97BF97F3, 0x80E8A40ECCD228A5 }, // -204
+        { 0xC8A883C0FDAF7DF0, 0x6122CD128006B2CE }, // -203
+        { 0xFAD2A4B13D1B5D6C, 0x796B805720085F82 }, // -202
+        { 0x9CC3A6EEC6311A63, 0xCBE3303674053BB1 }, // -201
+        { 0xC3F490AA77BD60FC, 0xBEDBFC4411068A9D }, // -200
+        { 0xF4F1B4D515ACB93B, 0xEE92FB5515482D45 }, // -199
+        { 0x991711052D8BF3C5, 0x751BDD152D4D1C4B }, // -198
+        { 0xBF5CD54678EEF0B6, 0xD262D45A78A0635E }, // -197
+        { 0xEF340A98172AACE4, 0x86FB897116C87C35 }, // -196
+        { 0x9580869F0E7AAC0E, 0xD45D35E6AE3D4DA1 }, // -195
+        { 0xBAE0A846D2195712, 0x8974836059CCA10A }, // -194
+        { 0xE998D258869FACD7, 0x2BD1A438703FC94C }, // -193
+        { 0x91FF83775423CC06, 0x7B6306A34627DDD0 }, // -192
+        { 0xB67F6455292CBF08, 0x1A3BC84C17B1D543 }, // -191
+        { 0xE41F3D6A7377EECA, 0x20CABA5F1D9E4A94 }, // -190
+        { 0x8E938662882AF53E, 0x547EB47B7282EE9D }, // -189
+        { 0xB23867FB2A35B28D, 0xE99E619A4F23AA44 }, // -188
+        { 0xDEC681F9F4C31F31, 0x6405FA00E2EC94D5 }, // -187
+        { 0x8B3C113C38F9F37E, 0xDE83BC408DD3DD05 }, // -186
+        { 0xAE0B158B4738705E, 0x9624AB50B148D446 }, // -185
+        { 0xD98DDAEE19068C76, 0x3BADD624DD9B0958 }, // -184
+        { 0x87F8A8D4CFA417C9, 0xE54CA5D70A80E5D7 }, // -183
+        { 0xA9F6D30A038D1DBC, 0x5E9FCF4CCD211F4D }, // -182
+        { 0xD47487CC8470652B, 0x7647C32000696720 }, // -181
+        { 0x84C8D4DFD2C63F3B, 0x29ECD9F40041E074 }, // -180
+        { 0xA5FB0A17C777CF09, 0xF468107100525891 }, // -179
+        { 0xCF79CC9DB955C2CC, 0x7182148D4066EEB5 }, // -178
+        { 0x81AC1FE293D599BF, 0xC6F14CD848405531 }, // -177
+        { 0xA21727DB38CB002F, 0xB8ADA00E5A506A7D }, // -176
+        { 0xCA9CF1D206FDC03B, 0xA6D90811F0E4851D }, // -175
+        { 0xFD442E4688BD304A, 0x908F4A166D1DA664 }, // -174
+        { 0x9E4A9CEC15763E2E, 0x9A598E4E043287FF }, // -173
+        { 0xC5DD44271AD3CDBA, 0x40EFF1E1853F29FE }, // -172
+        { 0xF7549530E188C128, 0xD12BEE59E68EF47D }, // -171
+        { 0x9A94DD3E8CF578B9, 0x82BB74F8301958CF }, // -170
+        { 0xC13A148E3032D6E7, 0xE36A52363C1FAF02 }, // -169
+        { 0xF18899B1BC3F8CA1, 0xDC44E6C3CB279AC2 }, // -168
+        { 0x96F5600F15A7B7E5, 0x29AB103A5EF8C0BA }, // -167
+        { 0xBCB2B812DB11A5DE, 0x7415D448F6B6F0E8 }, // -166
+        { 0xEBDF661791D60F56, 0x111B495B3464AD22 }, // -165
+        { 0x936B9FCEBB25C995, 0xCAB10DD900BEEC35 }, // -164
+        { 0xB84687C269EF3BFB, 0x3D5D514F40EEA743 }, // -163
+        { 0xE65829B3046B0AFA, 0x0CB4A5A3112A5113 }, // -162
+        { 0x8FF71A0FE2C2E6DC, 0x47F0E785EABA72AC }, // -161
+        { 0xB3F4E093DB73A093, 0x59ED216765690F57 }, // -160
+        { 0xE0F218B8D25088B8, 0x306869C13EC3532D }, // -159
+        { 0x8C974F7383725573, 0x1E414218C73A13FC }, // -158
+        { 0xAFBD2350644EEACF, 0xE5D1929EF90898FB }, // -157
+        { 0xDBAC6C247D62A583, 0xDF45F746B74ABF3A }, // -156
+        { 0x894BC396CE5DA772, 0x6B8BBA8C328EB784 }, // -155
+        { 0xAB9EB47C81F5114F, 0x066EA92F3F326565 }, // -154
+        { 0xD686619BA27255A2, 0xC80A537B0EFEFEBE }, // -153
+        { 0x8613FD0145877585, 0xBD06742CE95F5F37 }, // -152
+        { 0xA798FC4196E952E7, 0x2C48113823B73705 }, // -151
+        { 0xD17F3B51FCA3A7A0, 0xF75A15862CA504C6 }, // -150
+        { 0x82EF85133DE648C4, 0x9A984D73DBE722FC }, // -149
+        { 0xA3AB66580D5FDAF5, 0xC13E60D0D2E0EBBB }, // -148
+        { 0xCC963FEE10B7D1B3, 0x318DF905079926A9 }, // -147
+        { 0xFFBBCFE994E5C61F, 0xFDF17746497F7053 }, // -146
+        { 0x9FD561F1FD0F9BD3, 0xFEB6EA8BEDEFA634 }, // -145
+        { 0xC7CABA6E7C5382C8, 0xFE64A52EE96B8FC1 }, // -144
+        { 0xF9BD690A1B68637B, 0x3DFDCE7AA3C673B1 }, // -143
+        { 0x9C1661A651213E2D, 0x06BEA10CA65C084F }, // -142
+        { 0xC31BFA0FE5698DB8, 0x486E494FCFF30A63 }, // -141
+        { 0xF3E2F893DEC3F126, 0x5A89DBA3C3EFCCFB }, // -140
+        { 0x986DDB5C6B3A76B7, 0xF89629465A75E01D }, // -139
+        { 0xBE89523386091465, 0xF6BBB397F1135824 }, // -138
+        { 0xEE2BA6C0678B597F, 0x746AA07DED582E2D }, // -137
+        { 0x94DB483840B717EF, 0xA8C2A44EB4571CDD }, // -136
+        { 0xBA121A4650E4DDEB, 0x92F34D62616CE414 }, // -135
+        { 0xE896A0D7E51E1566, 0x77B020BAF9C81D18 }, // -134
+        { 0x915E2486EF32CD60, 0x0ACE1474DC1D122F }, // -133
+        { 0xB5B5ADA8AAFF80B8, 0x0D819992132456BB }, // -132
+        { 0xE3231912D5BF60E6, 0x10E1FFF697ED6C6A }, // -131
+        { 0x8DF5EFABC5979C8F, 0xCA8D3FFA1EF463C2 }, // -130
+        { 0xB1736B96B6FD83B3, 0xBD308FF8A6B17CB3 }, // -129
+        { 0xDDD0467C64BCE4A0, 0xAC7CB3F6D05DDBDF }, // -128
+        { 0x8AA22C0DBEF60EE4, 0x6BCDF07A423AA96C }, // -127
+        { 0xAD4AB7112EB3929D, 0x86C16C98D2C953C7 }, // -126
+        { 0xD89D64D57A607744, 0xE871C7BF077BA8B8 }, // -125
+        { 0x87625F056C7C4A8B, 0x11471CD764AD4973 }, // -124
+        { 0xA93AF6C6C79B5D2D, 0xD598E40D3DD89BD0 }, // -123
+        { 0xD389B47879823479, 0x4AFF1D108D4EC2C4 }, // -122
+        { 0x843610CB4BF160CB, 0xCEDF722A585139BB }, // -121
+        { 0xA54394FE1EEDB8FE, 0xC2974EB4EE658829 }, // -120
+        { 0xCE947A3DA6A9273E, 0x733D226229FEEA33 }, // -119
+        { 0x811CCC668829B887, 0x0806357D5A3F5260 }, // -118
+        { 0xA163FF802A3426A8, 0xCA07C2DCB0CF26F8 }, // -117
+        { 0xC9BCFF6034C13052, 0xFC89B393DD02F0B6 }, // -116
+        { 0xFC2C3F3841F17C67, 0xBBAC2078D443ACE3 }, // -115
+        { 0x9D9BA7832936EDC0, 0xD54B944B84AA4C0E }, // -114
+        { 0xC5029163F384A931, 0x0A9E795E65D4DF12 }, // -113
+        { 0xF64335BCF065D37D, 0x4D4617B5FF4A16D6 }, // -112
+        { 0x99EA0196163FA42E, 0x504BCED1BF8E4E46 }, // -111
+        { 0xC06481FB9BCF8D39, 0xE45EC2862F71E1D7 }, // -110
+        { 0xF07DA27A82C37088, 0x5D767327BB4E5A4D }, // -109
+        { 0x964E858C91BA2655, 0x3A6A07F8D510F870 }, // -108
+        { 0xBBE226EFB628AFEA, 0x890489F70A55368C }, // -107
+        { 0xEADAB0ABA3B2DBE5, 0x2B45AC74CCEA842F }, // -106
+        { 0x92C8AE6B464FC96F, 0x3B0B8BC90012929E }, // -105
+        { 0xB77ADA0617E3BBCB, 0x09CE6EBB40173745 }, // -104
+        { 0xE55990879DDCAABD, 0xCC420A6A101D0516 }, // -103
+        { 0x8F57FA54C2A9EAB6, 0x9FA946824A12232E }, // -102
+        { 0xB32DF8E9F3546564, 0x47939822DC96ABFA }, // -101
+        { 0xDFF9772470297EBD, 0x59787E2B93BC56F8 }, // -100
+        { 0x8BFBEA76C619EF36, 0x57EB4EDB3C55B65B }, // -99
+        { 0xAEFAE51477A06B03, 0xEDE622920B6B23F2 }, // -98
+        { 0xDAB99E59958885C4, 0xE95FAB368E45ECEE }, // -97
+        { 0x88B402F7FD75539B, 0x11DBCB0218EBB415 }, // -96
+        { 0xAAE103B5FCD2A881, 0xD652BDC29F26A11A }, // -95
+        { 0xD59944A37C0752A2, 0x4BE76D3346F04960 }, // -94
+        { 0x857FCAE62D8493A5, 0x6F70A4400C562DDC }, // -93
+        { 0xA6DFBD9FB8E5B88E, 0xCB4CCD500F6BB953 }, // -92
+        { 0xD097AD07A71F26B2, 0x7E2000A41346A7A8 }, // -91
+        { 0x825ECC24C873782F, 0x8ED400668C0C28C9 }, // -90
+        { 0xA2F67F2DFA90563B, 0x728900802F0F32FB }, // -89
+        { 0xCBB41EF979346BCA, 0x4F2B40A03AD2FFBA }, // -88
+        { 0xFEA126B7D78186BC, 0xE2F610C84987BFA9 }, // -87
+        { 0x9F24B832E6B0F436, 0x0DD9CA7D2DF4D7CA }, // -86
+        { 0xC6EDE63FA05D3143, 0x91503D1C79720DBC }, // -85
+        { 0xF8A95FCF88747D94, 0x75A44C6397CE912B }, // -84
+        { 0x9B69DBE1B548CE7C, 0xC986AFBE3EE11ABB }, // -83
+        { 0xC24452DA229B021B, 0xFBE85BADCE996169 }, // -82
+        { 0xF2D56790AB41C2A2, 0xFAE27299423FB9C4 }, // -81
+        { 0x97C560BA6B0919A5, 0xDCCD879FC967D41B }, // -80
+        { 0xBDB6B8E905CB600F, 0x5400E987BBC1C921 }, // -79
+        { 0xED246723473E3813, 0x290123E9AAB23B69 }, // -78
+        { 0x9436C0760C86E30B, 0xF9A0B6720AAF6522 }, // -77
+        { 0xB94470938FA89BCE, 0xF808E40E8D5B3E6A }, // -76
+        { 0xE7958CB87392C2C2, 0xB60B1D1230B20E05 }, // -75
+        { 0x90BD77F3483BB9B9, 0xB1C6F22B5E6F48C3 }, // -74
+        { 0xB4ECD5F01A4AA828, 0x1E38AEB6360B1AF4 }, // -73
+        { 0xE2280B6C20DD5232, 0x25C6DA63C38DE1B1 }, // -72
+        { 0x8D590723948A535F, 0x579C487E5A38AD0F }, // -71
+        { 0xB0AF48EC79ACE837, 0x2D835A9DF0C6D852 }, // -70
+        { 0xDCDB1B2798182244, 0xF8E431456CF88E66 }, // -69
+        { 0x8A08F0F8BF0F156B, 0x1B8E9ECB641B5900 }, // -68
+        { 0xAC8B2D36EED2DAC5, 0xE272467E3D222F40 }, // -67
+        { 0xD7ADF884AA879177, 0x5B0ED81DCC6ABB10 }, // -66
+        { 0x86CCBB52EA94BAEA, 0x98E947129FC2B4EA }, // -65
+        { 0xA87FEA27A539E9A5, 0x3F2398D747B36225 }, // -64
+        { 0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAE }, // -63
+        { 0x83A3EEEEF9153E89, 0x1953CF68300424AD }, // -62
+        { 0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD8 }, // -61
+        { 0xCDB02555653131B6, 0x3792F412CB06794E }, // -60
+        { 0x808E17555F3EBF11, 0xE2BBD88BBEE40BD1 }, // -59
+        { 0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC5 }, // -58
+        { 0xC8DE047564D20A8B, 0xF245825A5A445276 }, // -57
+        { 0xFB158592BE068D2E, 0xEED6E2F0F0D56713 }, // -56
+        { 0x9CED737BB6C4183D, 0x55464DD69685606C }, // -55
+        { 0xC428D05AA4751E4C, 0xAA97E14C3C26B887 }, // -54
+        { 0xF53304714D9265DF, 0xD53DD99F4B3066A9 }, // -53
+        { 0x993FE2C6D07B7FAB, 0xE546A8038EFE402A }, // -52
+        { 0xBF8FDB78849A5F96, 0xDE98520472BDD034 }, // -51
+        { 0xEF73D256A5C0F77C, 0x963E66858F6D4441 }, // -50
+        { 0x95A8637627989AAD, 0xDDE7001379A44AA9 }, // -49
+        { 0xBB127C53B17EC159, 0x5560C018580D5D53 }, // -48
+        { 0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A7 }, // -47
+        { 0x9226712162AB070D, 0xCAB3961304CA70E9 }, // -46
+        { 0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D23 }, // -45
+        { 0xE45C10C42A2B3B05, 0x8CB89A7DB77C506B }, // -44
+        { 0x8EB98A7A9A5B04E3, 0x77F3608E92ADB243 }, // -43
+        { 0xB267ED1940F1C61C, 0x55F038B237591ED4 }, // -42
+        { 0xDF01E85F912E37A3, 0x6B6C46DEC52F6689 }, // -41
+        { 0x8B61313BBABCE2C6, 0x2323AC4B3B3DA016 }, // -40
+        { 0xAE397D8AA96C1B77, 0xABEC975E0A0D081B }, // -39
+        { 0xD9C7DCED53C72255, 0x96E7BD358C904A22 }, // -38
+        { 0x881CEA14545C7575, 0x7E50D64177DA2E55 }, // -37
+        { 0xAA242499697392D2, 0xDDE50BD1D5D0B9EA }, // -36
+        { 0xD4AD2DBFC3D07787, 0x955E4EC64B44E865 }, // -35
+        { 0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113F }, // -34
+        { 0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58F }, // -33
+        { 0xCFB11EAD453994BA, 0x67DE18EDA5814AF3 }, // -32
+        { 0x81CEB32C4B43FCF4, 0x80EACF948770CED8 }, // -31
+        { 0xA2425FF75E14FC31, 0xA1258379A94D028E }, // -30
+        { 0xCAD2F7F5359A3B3E, 0x096EE45813A04331 }, // -29
+        { 0xFD87B5F28300CA0D, 0x8BCA9D6E188853FD }, // -28
+        { 0x9E74D1B791E07E48, 0x775EA264CF55347E }, // -27
+        { 0xC612062576589DDA, 0x95364AFE032A819E }, // -26
+        { 0xF79687AED3EEC551, 0x3A83DDBD83F52205 }, // -25
+        { 0x9ABE14CD44753B52, 0xC4926A9672793543 }, // -24
+        { 0xC16D9A0095928A27, 0x75B7053C0F178294 }, // -23
+        { 0xF1C90080BAF72CB1, 0x5324C68B12DD6339 }, // -22
+        { 0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04 }, // -21
+        { 0xBCE5086492111AEA, 0x88F4BB1CA6BCF585 }, // -20
+        { 0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6 }, // -19
+        { 0x9392EE8E921D5D07, 0x3AFF322E62439FD0 }, // -18
+        { 0xB877AA3236A4B449, 0x09BEFEB9FAD487C3 }, // -17
+        { 0xE69594BEC44DE15B, 0x4C2EBE687989A9B4 }, // -16
+        { 0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11 }, // -15
+        { 0xB424DC35095CD80F, 0x538484C19EF38C95 }, // -14
+        { 0xE12E13424BB40E13, 0x2865A5F206B06FBA }, // -13
+        { 0x8CBCCC096F5088CB, 0xF93F87B7442E45D4 }, // -12
+        { 0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749 }, // -11
+        { 0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C }, // -10
+        { 0x89705F4136B4A597, 0x31680A88F8953031 }, // -9
+        { 0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E }, // -8
+        { 0xD6BF94D5E57A42BC, 0x3D32907604691B4D }, // -7
+        { 0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110 }, // -6
+        { 0xA7C5AC471B478423, 0x0FCF80DC33721D54 }, // -5
+        { 0xD1B71758E219652B, 0xD3C36113404EA4A9 }, // -4
+        { 0x83126E978D4FDF3B, 0x645A1CAC083126EA }, // -3
+        { 0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4 }, // -2
+        { 0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD }, // -1
+        { 0x8000000000000000, 0x0000000000000001 }, // 0
+        { 0xA000000000000000, 0x0000000000000001 }, // 1
+        { 0xC800000000000000, 0x0000000000000001 }, // 2
+        { 0xFA00000000000000, 0x0000000000000001 }, // 3
+        { 0x9C40000000000000, 0x0000000000000001 }, // 4
+        { 0xC350000000000000, 0x0000000000000001 }, // 5
+        { 0xF424000000000000, 0x0000000000000001 }, // 6
+        { 0x9896800000000000, 0x0000000000000001 }, // 7
+        { 0xBEBC200000000000, 0x0000000000000001 }, // 8
+        { 0xEE6B280000000000, 0x0000000000000001 }, // 9
+        { 0x9502F90000000000, 0x0000000000000001 }, // 10
+        { 0xBA43B74000000000, 0x0000000000000001 }, // 11
+        { 0xE8D4A51000000000, 0x0000000000000001 }, // 12
+        { 0x9184E72A00000000, 0x0000000000000001 }, // 13
+        { 0xB5E620F480000000, 0x0000000000000001 }, // 14
+        { 0xE35FA931A0000000, 0x0000000000000001 }, // 15
+        { 0x8E1BC9BF04000000, 0x0000000000000001 }, // 16
+        { 0xB1A2BC2EC5000000, 0x0000000000000001 }, // 17
+        { 0xDE0B6B3A76400000, 0x0000000000000001 }, // 18
+        { 0x8AC7230489E80000, 0x0000000000000001 }, // 19
+        { 0xAD78EBC5AC620000, 0x0000000000000001 }, // 20
+        { 0xD8D726B7177A8000, 0x0000000000000001 }, // 21
+        { 0x878678326EAC9000, 0x0000000000000001 }, // 22
+        { 0xA968163F0A57B400, 0x0000000000000001 }, // 23
+        { 0xD3C21BCECCEDA100, 0x0000000000000001 }, // 24
+        { 0x84595161401484A0, 0x0000000000000001 }, // 25
+        { 0xA56FA5B99019A5C8, 0x0000000000000001 }, // 26
+        { 0xCECB8F27F4200F3A, 0x0000000000000001 }, // 27
+        { 0x813F3978F8940984, 0x4000000000000001 }, // 28
+        { 0xA18F07D736B90BE5, 0x5000000000000001 }, // 29
+        { 0xC9F2C9CD04674EDE, 0xA400000000000001 }, // 30
+        { 0xFC6F7C4045812296, 0x4D00000000000001 }, // 31
+        { 0x9DC5ADA82B70B59D, 0xF020000000000001 }, // 32
+        { 0xC5371912364CE305, 0x6C28000000000001 }, // 33
+        { 0xF684DF56C3E01BC6, 0xC732000000000001 }, // 34
+        { 0x9A130B963A6C115C, 0x3C7F400000000001 }, // 35
+        { 0xC097CE7BC90715B3, 0x4B9F100000000001 }, // 36
+        { 0xF0BDC21ABB48DB20, 0x1E86D40000000001 }, // 37
+        { 0x96769950B50D88F4, 0x1314448000000001 }, // 38
+        { 0xBC143FA4E250EB31, 0x17D955A000000001 }, // 39
+        { 0xEB194F8E1AE525FD, 0x5DCFAB0800000001 }, // 40
+        { 0x92EFD1B8D0CF37BE, 0x5AA1CAE500000001 }, // 41
+        { 0xB7ABC627050305AD, 0xF14A3D9E40000001 }, // 42
+        { 0xE596B7B0C643C719, 0x6D9CCD05D0000001 }, // 43
+        { 0x8F7E32CE7BEA5C6F, 0xE4820023A2000001 }, // 44
+        { 0xB35DBF821AE4F38B, 0xDDA2802C8A800001 }, // 45
+        { 0xE0352F62A19E306E, 0xD50B2037AD200001 }, // 46
+        { 0x8C213D9DA502DE45, 0x4526F422CC340001 }, // 47
+        { 0xAF298D050E4395D6, 0x9670B12B7F410001 }, // 48
+        { 0xDAF3F04651D47B4C, 0x3C0CDD765F114001 }, // 49
+        { 0x88D8762BF324CD0F, 0xA5880A69FB6AC801 }, // 50
+        { 0xAB0E93B6EFEE0053, 0x8EEA0D047A457A01 }, // 51
+        { 0xD5D238A4ABE98068, 0x72A4904598D6D881 }, // 52
+        { 0x85A36366EB71F041, 0x47A6DA2B7F864751 }, // 53
+        { 0xA70C3C40A64E6C51, 0x999090B65F67D925 }, // 54
+        { 0xD0CF4B50CFE20765, 0xFFF4B4E3F741CF6E }, // 55
+        { 0x82818F1281ED449F, 0xBFF8F10E7A8921A5 }, // 56
+        { 0xA321F2D7226895C7, 0xAFF72D52192B6A0E }, // 57
+        { 0xCBEA6F8CEB02BB39, 0x9BF4F8A69F764491 }, // 58
+        { 0xFEE50B7025C36A08, 0x02F236D04753D5B5 }, // 59
+        { 0x9F4F2726179A2245, 0x01D762422C946591 }, // 60
+        { 0xC722F0EF9D80AAD6, 0x424D3AD2B7B97EF6 }, // 61
+        { 0xF8EBAD2B84E0D58B, 0xD2E0898765A7DEB3 }, // 62
+        { 0x9B934C3B330C8577, 0x63CC55F49F88EB30 }, // 63
+        { 0xC2781F49FFCFA6D5, 0x3CBF6B71C76B25FC }, // 64
+        { 0xF316271C7FC3908A, 0x8BEF464E3945EF7B }, // 65
+        { 0x97EDD871CFDA3A56, 0x97758BF0E3CBB5AD }, // 66
+        { 0xBDE94E8E43D0C8EC, 0x3D52EEED1CBEA318 }, // 67
+        { 0xED63A231D4C4FB27, 0x4CA7AAA863EE4BDE }, // 68
+        { 0x945E455F24FB1CF8, 0x8FE8CAA93E74EF6B }, // 69
+        { 0xB975D6B6EE39E436, 0xB3E2FD538E122B45 }, // 70
+        { 0xE7D34C64A9C85D44, 0x60DBBCA87196B617 }, // 71
+        { 0x90E40FBEEA1D3A4A, 0xBC8955E946FE31CE }, // 72
+        { 0xB51D13AEA4A488DD, 0x6BABAB6398BDBE42 }, // 73
+        { 0xE264589A4DCDAB14, 0xC696963C7EED2DD2 }, // 74
+        { 0x8D7EB76070A08AEC, 0xFC1E1DE5CF543CA3 }, // 75
+        { 0xB0DE65388CC8ADA8, 0x3B25A55F43294BCC }, // 76
+        { 0xDD15FE86AFFAD912, 0x49EF0EB713F39EBF }, // 77
+        { 0x8A2DBF142DFCC7AB, 0x6E3569326C784338 }, // 78
+        { 0xACB92ED9397BF996, 0x49C2C37F07965405 }, // 79
+        { 0xD7E77A8F87DAF7FB, 0xDC33745EC97BE907 }, // 80
+        { 0x86F0AC99B4E8DAFD, 0x69A028BB3DED71A4 }, // 81
+        { 0xA8ACD7C0222311BC, 0xC40832EA0D68CE0D }, // 82
+        { 0xD2D80DB02AABD62B, 0xF50A3FA490C30191 }, // 83
+        { 0x83C7088E1AAB65DB, 0x792667C6DA79E0FB }, // 84
+        { 0xA4B8CAB1A1563F52, 0x577001B891185939 }, // 85
+        { 0xCDE6FD5E09ABCF26, 0xED4C0226B55E6F87 }, // 86
+        { 0x80B05E5AC60B6178, 0x544F8158315B05B5 }, // 87
+        { 0xA0DC75F1778E39D6, 0x696361AE3DB1C722 }, // 88
+        { 0xC913936DD571C84C, 0x03BC3A19CD1E38EA }, // 89
+        { 0xFB5878494ACE3A5F, 0x04AB48A04065C724 }, // 90
+        { 0x9D174B2DCEC0E47B, 0x62EB0D64283F9C77 }, // 91
+        { 0xC45D1DF942711D9A, 0x3BA5D0BD324F8395 }, // 92
+        { 0xF5746577930D6500, 0xCA8F44EC7EE3647A }, // 93
+        { 0x9968BF6ABBE85F20, 0x7E998B13CF4E1ECC }, // 94
+        { 0xBFC2EF456AE276E8, 0x9E3FEDD8C321A67F }, // 95
+        { 0xEFB3AB16C59B14A2, 0xC5CFE94EF3EA101F }, // 96
+        { 0x95D04AEE3B80ECE5, 0xBBA1F1D158724A13 }, // 97
+        { 0xBB445DA9CA61281F, 0x2A8A6E45AE8EDC98 }, // 98
+        { 0xEA1575143CF97226, 0xF52D09D71A3293BE }, // 99
+        { 0x924D692CA61BE758, 0x593C2626705F9C57 }, // 100
+        { 0xB6E0C377CFA2E12E, 0x6F8B2FB00C77836D }, // 101
+        { 0xE498F455C38B997A, 0x0B6DFB9C0F956448 }, // 102
+        { 0x8EDF98B59A373FEC, 0x4724BD4189BD5EAD }, // 103
+        { 0xB2977EE300C50FE7, 0x58EDEC91EC2CB658 }, // 104
+        { 0xDF3D5E9BC0F653E1, 0x2F2967B66737E3EE }, // 105
+        { 0x8B865B215899F46C, 0xBD79E0D20082EE75 }, // 106
+        { 0xAE67F1E9AEC07187, 0xECD8590680A3AA12 }, // 107
+        { 0xDA01EE641A708DE9, 0xE80E6F4820CC9496 }, // 108
+        { 0x884134FE908658B2, 0x3109058D147FDCDE }, // 109
+        { 0xAA51823E34A7EEDE, 0xBD4B46F0599FD416 }, // 110
+        { 0xD4E5E2CDC1D1EA96, 0x6C9E18AC7007C91B }, // 111
+        { 0x850FADC09923329E, 0x03E2CF6BC604DDB1 }, // 112
+        { 0xA6539930BF6BFF45, 0x84DB8346B786151D }, // 113
+        { 0xCFE87F7CEF46FF16, 0xE612641865679A64 }, // 114
+        { 0x81F14FAE158C5F6E, 0x4FCB7E8F3F60C07F }, // 115
+        { 0xA26DA3999AEF7749, 0xE3BE5E330F38F09E }, // 116
+        { 0xCB090C8001AB551C, 0x5CADF5BFD3072CC6 }, // 117
+        { 0xFDCB4FA002162A63, 0x73D9732FC7C8F7F7 }, // 118
+        { 0x9E9F11C4014DDA7E, 0x2867E7FDDCDD9AFB }, // 119
+        { 0xC646D63501A1511D, 0xB281E1FD541501B9 }, // 120
+        { 0xF7D88BC24209A565, 0x1F225A7CA91A4227 }, // 121
+        { 0x9AE757596946075F, 0x3375788DE9B06959 }, // 122
+        { 0xC1A12D2FC3978937, 0x0052D6B1641C83AF }, // 123
+        { 0xF209787BB47D6B84, 0xC0678C5DBD23A49B }, // 124
+        { 0x9745EB4D50CE6332, 0xF840B7BA963646E1 }, // 125
+        { 0xBD176620A501FBFF, 0xB650E5A93BC3D899 }, // 126
+        { 0xEC5D3FA8CE427AFF, 0xA3E51F138AB4CEBF }, // 127
+        { 0x93BA47C980E98CDF, 0xC66F336C36B10138 }, // 128
+        { 0xB8A8D9BBE123F017, 0xB80B0047445D4185 }, // 129
+        { 0xE6D3102AD96CEC1D, 0xA60DC059157491E6 }, // 130
+        { 0x9043EA1AC7E41392, 0x87C89837AD68DB30 }, // 131
+        { 0xB454E4A179DD1877, 0x29BABE4598C311FC }, // 132
+        { 0xE16A1DC9D8545E94, 0xF4296DD6FEF3D67B }, // 133
+        { 0x8CE2529E2734BB1D, 0x1899E4A65F58660D }, // 134
+        { 0xB01AE745B101E9E4, 0x5EC05DCFF72E7F90 }, // 135
+        { 0xDC21A1171D42645D, 0x76707543F4FA1F74 }, // 136
+        { 0x899504AE72497EBA, 0x6A06494A791C53A9 }, // 137
+        { 0xABFA45DA0EDBDE69, 0x0487DB9D17636893 }, // 138
+        { 0xD6F8D7509292D603, 0x45A9D2845D3C42B7 }, // 139
+        { 0x865B86925B9BC5C2, 0x0B8A2392BA45A9B3 }, // 140
+        { 0xA7F26836F282B732, 0x8E6CAC7768D7141F }, // 141
+        { 0xD1EF0244AF2364FF, 0x3207D795430CD927 }, // 142
+        { 0x8335616AED761F1F, 0x7F44E6BD49E807B9 }, // 143
+        { 0xA402B9C5A8D3A6E7, 0x5F16206C9C6209A7 }, // 144
+        { 0xCD036837130890A1, 0x36DBA887C37A8C10 }, // 145
+        { 0x802221226BE55A64, 0xC2494954DA2C978A }, // 146
+        { 0xA02AA96B06DEB0FD, 0xF2DB9BAA10B7BD6D }, // 147
+        { 0xC83553C5C8965D3D, 0x6F92829494E5ACC8 }, // 148
+        { 0xFA42A8B73ABBF48C, 0xCB772339BA1F17FA }, // 149
+        { 0x9C69A97284B578D7, 0xFF2A760414536EFC }, // 150
+        { 0xC38413CF25E2D70D, 0xFEF5138519684ABB }, // 151
+        { 0xF46518C2EF5B8CD1, 0x7EB258665FC25D6A }, // 152
+        { 0x98BF2F79D5993802, 0xEF2F773FFBD97A62 }, // 153
+        { 0xBEEEFB584AFF8603, 0xAAFB550FFACFD8FB }, // 154
+        { 0xEEAABA2E5DBF6784, 0x95BA2A53F983CF39 }, // 155
+        { 0x952AB45CFA97A0B2, 0xDD945A747BF26184 }, // 156
+        { 0xBA756174393D88DF, 0x94F971119AEEF9E5 }, // 157
+        { 0xE912B9D1478CEB17, 0x7A37CD5601AAB85E }, // 158
+        { 0x91ABB422CCB812EE, 0xAC62E055C10AB33B }, // 159
+        { 0xB616A12B7FE617AA, 0x577B986B314D600A }, // 160
+        { 0xE39C49765FDF9D94, 0xED5A7E85FDA0B80C }, // 161
+        { 0x8E41ADE9FBEBC27D, 0x14588F13BE847308 }, // 162
+        { 0xB1D219647AE6B31C, 0x596EB2D8AE258FC9 }, // 163
+        { 0xDE469FBD99A05FE3, 0x6FCA5F8ED9AEF3BC }, // 164
+        { 0x8AEC23D680043BEE, 0x25DE7BB9480D5855 }, // 165
+        { 0xADA72CCC20054AE9, 0xAF561AA79A10AE6B }, // 166
+        { 0xD910F7FF28069DA4, 0x1B2BA1518094DA05 }, // 167
+        { 0x87AA9AFF79042286, 0x90FB44D2F05D0843 }, // 168
+        { 0xA99541BF57452B28, 0x353A1607AC744A54 }, // 169
+        { 0xD3FA922F2D1675F2, 0x42889B8997915CE9 }, // 170
+        { 0x847C9B5D7C2E09B7, 0x69956135FEBADA12 }, // 171
+        { 0xA59BC234DB398C25, 0x43FAB9837E699096 }, // 172
+        { 0xCF02B2C21207EF2E, 0x94F967E45E03F4BC }, // 173
+        { 0x8161AFB94B44F57D, 0x1D1BE0EEBAC278F6 }, // 174
+        { 0xA1BA1BA79E1632DC, 0x6462D92A69731733 }, // 175
+        { 0xCA28A291859BBF93, 0x7D7B8F7503CFDCFF }, // 176
+        { 0xFCB2CB35E702AF78, 0x5CDA735244C3D43F }, // 177
+        { 0x9DEFBF01B061ADAB, 0x3A0888136AFA64A8 }, // 178
+        { 0xC56BAEC21C7A1916, 0x088AAA1845B8FDD1 }, // 179
+        { 0xF6C69A72A3989F5B, 0x8AAD549E57273D46 }, // 180
+        { 0x9A3C2087A63F6399, 0x36AC54E2F678864C }, // 181
+        { 0xC0CB28A98FCF3C7F, 0x84576A1BB416A7DE }, // 182
+        { 0xF0FDF2D3F3C30B9F, 0x656D44A2A11C51D6 }, // 183
+        { 0x969EB7C47859E743, 0x9F644AE5A4B1B326 }, // 184
+        { 0xBC4665B596706114, 0x873D5D9F0DDE1FEF }, // 185
+        { 0xEB57FF22FC0C7959, 0xA90CB506D155A7EB }, // 186
+        { 0x9316FF75DD87CBD8, 0x09A7F12442D588F3 }, // 187
+        { 0xB7DCBF5354E9BECE, 0x0C11ED6D538AEB30 }, // 188
+        { 0xE5D3EF282A242E81, 0x8F1668C8A86DA5FB }, // 189
+        { 0x8FA475791A569D10, 0xF96E017D694487BD }, // 190
+        { 0xB38D92D760EC4455, 0x37C981DCC395A9AD }, // 191
+        { 0xE070F78D3927556A, 0x85BBE253F47B1418 }, // 192
+        { 0x8C469AB843B89562, 0x93956D7478CCEC8F }, // 193
+        { 0xAF58416654A6BABB, 0x387AC8D1970027B3 }, // 194
+        { 0xDB2E51BFE9D0696A, 0x06997B05FCC0319F }, // 195
+        { 0x88FCF317F22241E2, 0x441FECE3BDF81F04 }, // 196
+        { 0xAB3C2FDDEEAAD25A, 0xD527E81CAD7626C4 }, // 197
+        { 0xD60B3BD56A5586F1, 0x8A71E223D8D3B075 }, // 198
+        { 0x85C7056562757456, 0xF6872D5667844E4A }, // 199
+        { 0xA738C6BEBB12D16C, 0xB428F8AC016561DC }, // 200
+        { 0xD106F86E69D785C7, 0xE13336D701BEBA53 }, // 201
+        { 0x82A45B450226B39C, 0xECC0024661173474 }, // 202
+        { 0xA34D721642B06084, 0x27F002D7F95D0191 }, // 203
+        { 0xCC20CE9BD35C78A5, 0x31EC038DF7B441F5 }, // 204
+        { 0xFF290242C83396CE, 0x7E67047175A15272 }, // 205
+        { 0x9F79A169BD203E41, 0x0F0062C6E984D387 }, // 206
+        { 0xC75809C42C684DD1, 0x52C07B78A3E60869 }, // 207
+        { 0xF92E0C3537826145, 0xA7709A56CCDF8A83 }, // 208
+        { 0x9BBCC7A142B17CCB, 0x88A66076400BB692 }, // 209
+        { 0xC2ABF989935DDBFE, 0x6ACFF893D00EA436 }, // 210
+        { 0xF356F7EBF83552FE, 0x0583F6B8C4124D44 }, // 211
+        { 0x98165AF37B2153DE, 0xC3727A337A8B704B }, // 212
+        { 0xBE1BF1B059E9A8D6, 0x744F18C0592E4C5D }, // 213
+        { 0xEDA2EE1C7064130C, 0x1162DEF06F79DF74 }, // 214
+        { 0x9485D4D1C63E8BE7, 0x8ADDCB5645AC2BA9 }, // 215
+        { 0xB9A74A0637CE2EE1, 0x6D953E2BD7173693 }, // 216
+        { 0xE8111C87C5C1BA99, 0xC8FA8DB6CCDD0438 }, // 217
+        { 0x910AB1D4DB9914A0, 0x1D9C9892400A22A3 }, // 218
+        { 0xB54D5E4A127F59C8, 0x2503BEB6D00CAB4C }, // 219
+        { 0xE2A0B5DC971F303A, 0x2E44AE64840FD61E }, // 220
+        { 0x8DA471A9DE737E24, 0x5CEAECFED289E5D3 }, // 221
+        { 0xB10D8E1456105DAD, 0x7425A83E872C5F48 }, // 222
+        { 0xDD50F1996B947518, 0xD12F124E28F7771A }, // 223
+        { 0x8A5296FFE33CC92F, 0x82BD6B70D99AAA70 }, // 224
+        { 0xACE73CBFDC0BFB7B, 0x636CC64D1001550C }, // 225
+        { 0xD8210BEFD30EFA5A, 0x3C47F7E05401AA4F }, // 226
+        { 0x8714A775E3E95C78, 0x65ACFAEC34810A72 }, // 227
+        { 0xA8D9D1535CE3B396, 0x7F1839A741A14D0E }, // 228
+        { 0xD31045A8341CA07C, 0x1EDE48111209A051 }, // 229
+        { 0x83EA2B892091E44D, 0x934AED0AAB460433 }, // 230
+        { 0xA4E4B66B68B65D60, 0xF81DA84D56178540 }, // 231
+        { 0xCE1DE40642E3F4B9, 0x36251260AB9D668F }, // 232
+        { 0x80D2AE83E9CE78F3, 0xC1D72B7C6B42601A }, // 233
+        { 0xA1075A24E4421730, 0xB24CF65B8612F820 }, // 234
+        { 0xC94930AE1D529CFC, 0xDEE033F26797B628 }, // 235
+        { 0xFB9B7CD9A4A7443C, 0x169840EF017DA3B2 }, // 236
+        { 0x9D412E0806E88AA5, 0x8E1F289560EE864F }, // 237
+        { 0xC491798A08A2AD4E, 0xF1A6F2BAB92A27E3 }, // 238
+        { 0xF5B5D7EC8ACB58A2, 0xAE10AF696774B1DC }, // 239
+        { 0x9991A6F3D6BF1765, 0xACCA6DA1E0A8EF2A }, // 240
+        { 0xBFF610B0CC6EDD3F, 0x17FD090A58D32AF4 }, // 241
+        { 0xEFF394DCFF8A948E, 0xDDFC4B4CEF07F5B1 }, // 242
+        { 0x95F83D0A1FB69CD9, 0x4ABDAF101564F98F }, // 243
+        { 0xBB764C4CA7A4440F, 0x9D6D1AD41ABE37F2 }, // 244
+        { 0xEA53DF5FD18D5513, 0x84C86189216DC5EE }, // 245
+        { 0x92746B9BE2F8552C, 0x32FD3CF5B4E49BB5 }, // 246
+        { 0xB7118682DBB66A77, 0x3FBC8C33221DC2A2 }, // 247
+        { 0xE4D5E82392A40515, 0x0FABAF3FEAA5334B }, // 248
+        { 0x8F05B1163BA6832D, 0x29CB4D87F2A7400F }, // 249
+        { 0xB2C71D5BCA9023F8, 0x743E20E9EF511013 }, // 250
+        { 0xDF78E4B2BD342CF6, 0x914DA9246B255417 }, // 251
+        { 0x8BAB8EEFB6409C1A, 0x1AD089B6C2F7548F }, // 252
+        { 0xAE9672ABA3D0C320, 0xA184AC2473B529B2 }, // 253
+        { 0xDA3C0F568CC4F3E8, 0xC9E5D72D90A2741F }, // 254
+        { 0x8865899617FB1871, 0x7E2FA67C7A658893 }, // 255
+        { 0xAA7EEBFB9DF9DE8D, 0xDDBB901B98FEEAB8 }, // 256
+        { 0xD51EA6FA85785631, 0x552A74227F3EA566 }, // 257
+        { 0x8533285C936B35DE, 0xD53A88958F872760 }, // 258
+        { 0xA67FF273B8460356, 0x8A892ABAF368F138 }, // 259
+        { 0xD01FEF10A657842C, 0x2D2B7569B0432D86 }, // 260
+        { 0x8213F56A67F6B29B, 0x9C3B29620E29FC74 }, // 261
+        { 0xA298F2C501F45F42, 0x8349F3BA91B47B90 }, // 262
+        { 0xCB3F2F7642717713, 0x241C70A936219A74 }, // 263
+        { 0xFE0EFB53D30DD4D7, 0xED238CD383AA0111 }, // 264
+        { 0x9EC95D1463E8A506, 0xF4363804324A40AB }, // 265
+        { 0xC67BB4597CE2CE48, 0xB143C6053EDCD0D6 }, // 266
+        { 0xF81AA16FDC1B81DA, 0xDD94B7868E94050B }, // 267
+        { 0x9B10A4E5E9913128, 0xCA7CF2B4191C8327 }, // 268
+        { 0xC1D4CE1F63F57D72, 0xFD1C2F611F63A3F1 }, // 269
+        { 0xF24A01A73CF2DCCF, 0xBC633B39673C8CED }, // 270
+        { 0x976E41088617CA01, 0xD5BE0503E085D814 }, // 271
+        { 0xBD49D14AA79DBC82, 0x4B2D8644D8A74E19 }, // 272
+        { 0xEC9C459D51852BA2, 0xDDF8E7D60ED1219F }, // 273
+        { 0x93E1AB8252F33B45, 0xCABB90E5C942B504 }, // 274
+        { 0xB8DA1662E7B00A17, 0x3D6A751F3B936244 }, // 275
+        { 0xE7109BFBA19C0C9D, 0x0CC512670A783AD5 }, // 276
+        { 0x906A617D450187E2, 0x27FB2B80668B24C6 }, // 277
+        { 0xB484F9DC9641E9DA, 0xB1F9F660802DEDF7 }, // 278
+        { 0xE1A63853BBD26451, 0x5E7873F8A0396974 }, // 279
+        { 0x8D07E33455637EB2, 0xDB0B487B6423E1E9 }, // 280
+        { 0xB049DC016ABC5E5F, 0x91CE1A9A3D2CDA63 }, // 281
+        { 0xDC5C5301C56B75F7, 0x7641A140CC7810FC }, // 282
+        { 0x89B9B3E11B6329BA, 0xA9E904C87FCB0A9E }, // 283
+        { 0xAC2820D9623BF429, 0x546345FA9FBDCD45 }, // 284
+        { 0xD732290FBACAF133, 0xA97C177947AD4096 }, // 285
+        { 0x867F59A9D4BED6C0, 0x49ED8EABCCCC485E }, // 286
+        { 0xA81F301449EE8C70, 0x5C68F256BFFF5A75 }, // 287
+        { 0xD226FC195C6A2F8C, 0x73832EEC6FFF3112 }, // 288
+        { 0x83585D8FD9C25DB7, 0xC831FD53C5FF7EAC }, // 289
+        { 0xA42E74F3D032F525, 0xBA3E7CA8B77F5E56 }, // 290
+        { 0xCD3A1230C43FB26F, 0x28CE1BD2E55F35EC }, // 291
+        { 0x80444B5E7AA7CF85, 0x7980D163CF5B81B4 }, // 292
+        { 0xA0555E361951C366, 0xD7E105BCC3326220 }, // 293
+        { 0xC86AB5C39FA63440, 0x8DD9472BF3FEFAA8 }, // 294
+        { 0xFA856334878FC150, 0xB14F98F6F0FEB952 }, // 295
+        { 0x9C935E00D4B9D8D2, 0x6ED1BF9A569F33D4 }, // 296
+        { 0xC3B8358109E84F07, 0x0A862F80EC4700C9 }, // 297
+        { 0xF4A642E14C6262C8, 0xCD27BB612758C0FB }, // 298
+        { 0x98E7E9CCCFBD7DBD, 0x8038D51CB897789D }, // 299
+        { 0xBF21E44003ACDD2C, 0xE0470A63E6BD56C4 }, // 300
+        { 0xEEEA5D5004981478, 0x1858CCFCE06CAC75 }, // 301
+        { 0x95527A5202DF0CCB, 0x0F37801E0C43EBC9 }, // 302
+        { 0xBAA718E68396CFFD, 0xD30560258F54E6BB }, // 303
+        { 0xE950DF20247C83FD, 0x47C6B82EF32A206A }, // 304
+        { 0x91D28B7416CDD27E, 0x4CDC331D57FA5442 }, // 305
+        { 0xB6472E511C81471D, 0xE0133FE4ADF8E953 }, // 306
+        { 0xE3D8F9E563A198E5, 0x58180FDDD97723A7 }, // 307
+        { 0x8E679C2F5E44FF8F, 0x570F09EAA7EA7649 }, // 308
+        { 0xB201833B35D63F73, 0x2CD2CC6551E513DB }, // 309
+        { 0xDE81E40A034BCF4F, 0xF8077F7EA65E58D2 }, // 310
+        { 0x8B112E86420F6191, 0xFB04AFAF27FAF783 }, // 311
+        { 0xADD57A27D29339F6, 0x79C5DB9AF1F9B564 }, // 312
+        { 0xD94AD8B1C7380874, 0x18375281AE7822BD }, // 313
+        { 0x87CEC76F1C830548, 0x8F2293910D0B15B6 }, // 314
+        { 0xA9C2794AE3A3C69A, 0xB2EB3875504DDB23 }, // 315
+        { 0xD433179D9C8CB841, 0x5FA60692A46151EC }, // 316
+        { 0x849FEEC281D7F328, 0xDBC7C41BA6BCD334 }, // 317
+        { 0xA5C7EA73224DEFF3, 0x12B9B522906C0801 }, // 318
+        { 0xCF39E50FEAE16BEF, 0xD768226B34870A01 }, // 319
+        { 0x81842F29F2CCE375, 0xE6A1158300D46641 }, // 320
+        { 0xA1E53AF46F801C53, 0x60495AE3C1097FD1 }, // 321
+        { 0xCA5E89B18B602368, 0x385BB19CB14BDFC5 }, // 322
+        { 0xFCF62C1DEE382C42, 0x46729E03DD9ED7B6 }, // 323
+        { 0x9E19DB92B4E31BA9, 0x6C07A2C26A8346D2 }, // 324
+};
+
+// floor(x / 2^n), also for negative x
+static int ds__floor_shift(int x, int n) {
+        return x >= 0 ? x >> n : -((-x + (1 << n) - 1) >> n);
+}
+
+// high and low 64 bits of a * b
+static void ds__mul_128(uint64_t a, uint64_t b, uint64_t *high, 
+                        uint64_t *low) {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 ds__uint128_t;
+        ds__uint128_t product = (ds__uint128_t)a * b;
+        *high = (uint64_t)(product >> 64);
+        *low = (uint64_t)product;
+#else
+        uint64_t a_low = (uint32_t)a, a_high = a >> 32;
+        uint64_t b_low = (uint32_t)b, b_high = b >> 32;
+        uint64_t low_low = a_low * b_low;
+        uint64_t high_low = a_high * b_low;
+        uint64_t low_high = a_low * b_high;
+        uint64_t middle = high_low + (low_low >> 32) + (uint32_t)low_high;
+        *high = a_high * b_high + (middle >> 32) + (low_high >> 32);
+        *low = (middle << 32) | (uint32_t)low_low;
+#endif
+}
+
+// (g * cp) >> 128, with the lowest bit set if any bit was dropped
+static uint64_t ds__round_to_odd(const uint64_t g[2], uint64_t cp) {
+        uint64_t x_high, x_low, y_high, y_low;
+        ds__mul_128(g[1], cp, &x_high, &x_low);
+        ds__mul_128(g[0], cp, &y_high, &y_low);
+        uint64_t z = y_low + x_high;
+        uint64_t z_high = y_high + (z < y_low);
+        return z_high | (z > 1);
+}
+
+// shortest decimal digits * 10^exponent that reads back as the finite,
+// non zero double with the given bits (the sign is ignored)
+//
+// this is Schubfach (R. Giulietti, "The Schubfach way to render doubles")
+static void ds__double_to_decimal(uint64_t bits, uint64_t *digits, 
+                                  int *exponent) {
+        uint64_t fraction = bits & ((1ULL << 52) - 1);
+        int biased = (int)((bits >> 52) & 0x7ff);
+        uint64_t c;
+        int q;
+        if (biased != 0) {
+                c = fraction | (1ULL << 52);
+                q = biased - 1075;
+                // small integers are exact
+                if (q <= 0 && q > -53 && (c & ((1ULL << -q) - 1)) == 0) {
+                        *digits = c >> -q;
+                        *exponent = 0;
+                        return;
+                }
+        } else {
+                c = fraction;
+                q = -1074;
+        }
+
+        int even = (c & 1) == 0;
+        int closer = fraction == 0 && biased > 1;
+        uint64_t cbl = 4 * c - 2 + closer;
+        uint64_t cb = 4 * c;
+        uint64_t cbr = 4 * c + 2;
+
+        // floor(log10(2^q)), or floor(log10(3/4 2^q)) when closer
+        int k = ds__floor_shift(q * 1262611 - (closer ? 524031 : 0), 22);
+        // h is in [1, 4], floor(log2(10^-k)) comes from the same trick
+        int h = q + ds__floor_shift(-k * 1741647, 19) + 1;
+        const uint64_t *g = 
+                ds__pow10_significands[-k - DS__POW10_MIN_EXPONENT];
+        uint64_t vbl = ds__round_to_odd(g, cbl << h);
+        uint64_t vb = ds__round_to_odd(g, cb << h);
+        uint64_t vbr = ds__round_to_odd(g, cbr << h);
+        uint64_t lower = vbl + !even;
+        uint64_t upper = vbr - !even;
+
+        // try one digit less first, at most one of the two fits
+        uint64_t s = vb / 4;
+        if (s >= 10) {
+                uint64_t sp = s / 10;
+                int up_inside = lower <= 40 * sp;
+                int wp_inside = 40 * sp + 40 <= upper;
+                if (up_inside != wp_inside) {
+                        *digits = sp + wp_inside;
+                        *exponent = k + 1;
+                        return;
+                }
+        }
+
+        int u_inside = lower <= 4 * s;
+        int w_inside = 4 * s + 4 <= upper;
+        if (u_inside != w_inside) {
+                *digits = s + w_inside;
+                *exponent = k;
+                return;
+        }
+
+        uint64_t middle = 4 * s + 2;
+        *digits = s + (vb > middle || (vb == middle && (s & 1) != 0));
+        *exponent = k;
+}
+
+// append a double so that it reads back to the same value
+//
+// the digits are the shortest that round trip, found without printf or
+// strtod, so the output does not depend on the locale
+// decimal exponents from -4 to 16 are written in fixed notation, others
+// like %g does (1.5e+20, 5e-324)
+// nan and infinities are written as nan, inf and -inf
+// returns 0 if nothing went wrong
+int string_builder_append_double(struct string_builder_t *sb, 
+                                 double value) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        int negative = (int)(bits >> 63);
+        bits &= ~(1ULL << 63);
+        if (bits >= 0x7ff0000000000000ULL) {
+                if (bits > 0x7ff0000000000000ULL) {
+                        return string_builder_append(sb, "nan");
+                }
+                return string_builder_append(sb, negative ? "-inf" : "inf");
+        }
+
+        // "-0.0000" and 17 digits, or "-d." 16 digits and "e-324"
+        int err = ds__string_builder_reserve(sb, 32);
+        if (err) {
+                return err;
+        }
+        char *chars = ds__string_builder_chars(sb) + sb->count;
+        char *at = chars;
+        if (negative) {
+                *at++ = '-';
+        }
+        if (bits == 0) {
+                *at++ = '0';
+                sb->count += (int)(at - chars);
+                DS__STATS_ADD(sb, memcpy_bytes, at - chars);
+                return DS_NO_ERROR;
+        }
+
+        uint64_t digits;
+        int exponent;
+        ds__double_to_decimal(bits, &digits, &exponent);
+        while (digits % 10 == 0) {
+                digits /= 10;
+                exponent++;
+        }
+        int count = ds__count_digits(digits);
+        int point = count + exponent;   // digits before the decimal point
+
+        if (point > -4 && point <= 17) {
+                if (point <= 0) {
+                        *at++ = '0';
+                        *at++ = '.';
+                        memset(at, '0', -point);
+                        at += -point;
+                        ds__write_decimal(at + count, digits);
+                        at += count;
+                } else if (point >= count) {
+                        ds__write_decimal(at + count, digits);
+                        memset(at + count, '0', point - count);
+                        at += point;
+                } else {
+                        ds__write_decimal(at + count, digits);
+                        memmove(at + point + 1, at + point, count - point);
+                        at[point] = '.';
+                        at += count + 1;
+                }
+        } else {
+                // write the digits one place to the right, then pull the
+                // first one in front of the decimal point
+                ds__write_decimal(at + 1 + count, digits);
+                at[0] = at[1];
+                if (count > 1) {
+                        at[1] = '.';
+                        at += count + 1;
+                } else {
+                        at += 1;
+                }
+                int power = point - 1;
+                *at++ = 'e';
+                *at++ = power < 0 ? '-' : '+';
+                power = power < 0 ? -power : power;
+                int power_digits = power < 10 ? 2 : ds__count_digits(power);
+                ds__write_decimal(at + power_digits, power);
+                if (power < 10) {
+                        at[0] = '0';
+                }
+                at += power_digits;
+        }
+
+        sb->count += (int)(at - chars);
+        DS__STATS_ADD(sb, memcpy_bytes, at - chars);
+        return DS_NO_ERROR;
+}
+
+// append a given string n times
+//
+// returns 0 if nothing went wrong
+int string_builder_appendn(struct string_builder_t *sb, const char *str,
+                           int len) {
+        if (sb == NULL || str == NULL || len < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        size_t str_len = strlen(str);
+        if (str_len == 0 || len == 0) {
+                return DS_NO_ERROR;
+        }
+        if (str_len > (size_t)(INT_MAX / len)) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int err = ds__string_builder_reserve(sb, (int)str_len * len);
+        if (err) {
+                return err;
+        }
+
+        char *chars = ds__string_builder_chars(sb);
+        for (int i = 0; i < len; i++) {
+                memcpy(chars + sb->count, str, str_len);
+                sb->count += (int)str_len;
+        }
+        DS__STATS_ADD(sb, memcpy_bytes, (long long)str_len * len);
+
+        return DS_NO_ERROR;
+}
+
+// append a given string
+//
+// returns 0 if nothing went wrong
+int string_builder_append(struct string_builder_t *sb, const char *str) {
+        return string_builder_appendn(sb, str, 1);
+}
+
+// append a given character
+// 
+// return 0 if nothing went wrong
+int string_builder_appendc(struct string_builder_t *sb, char ch) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (sb->count + 1 >= sb->capacity) {
+                int err = ds__string_builder_reserve(sb, 1);
+                if (err) {
+                        return err;
+                }
+        }
+        ds__string_builder_chars(sb)[sb->count++] = ch;
+        DS__STATS_ADD(sb, memcpy_bytes, 1);
+
+        return DS_NO_ERROR;
+}
+
+// append a given character n times
+//
+// returns 0 if nothing went wrong
+int string_builder_appendcn(struct string_builder_t *sb, char ch, int len) {
+        if (sb == NULL || len < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int err = ds__string_builder_reserve(sb, len);
+        if (err) {
+                return err;
+        }
+        memset(ds__string_builder_chars(sb) + sb->count, ch, len);
+        sb->count += len;
+        DS__STATS_ADD(sb, memcpy_bytes, len);
+
+        return DS_NO_ERROR;
+}
+
+// build the string and allocate the string to the provided pointer
+//
+// the string is allocated with the allocator of the string builder
+// the string builder is left untouched
+// returns 0 if nothing goes wrong
+int string_builder_build(struct string_builder_t *sb, char **str) {
+        if (sb == NULL || str == NULL) { 
+                return DS_ARGUMENT_ERROR;
+        }
+
+        *str = ds_alloc(sb->allocator, sizeof(char) * sb->count + 1);
+        if (*str == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+
+        if (sb->count > 0) {
+                memcpy(*str, ds__string_builder_chars(sb), sb->count);
+        }
+        DS__STATS_ADD(sb, memcpy_bytes, sb->count);
+        (*str)[sb->count] = 0;
+
+        return DS_NO_ERROR;
+}
+
+// get a view of the string builder contents without copying
+//
+// the view is not null terminated
+// returns 0 if nothing goes wrong
+int string_builder_view(struct string_builder_t *sb, 
+                        struct string_view_t *view) {
+        if (sb == NULL || view == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        view->data = ds__string_builder_chars(sb);
+        view->length = sb->count;
+        return DS_NO_ERROR;
+}
+
+// get the string builder contents as a null terminated string
+//
+// there is always room for the terminator, so this never copies
+// returns 0 if nothing goes wrong
+int string_builder_cstr(struct string_builder_t *sb, const char **str) {
+        if (sb == NULL || str == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        char *chars = ds__string_builder_chars(sb);
+        chars[sb->count] = 0;
+        *str = chars;
+        return DS_NO_ERROR;
+}
+
+// take the null terminated storage of the string builder
+//
+// the buffer is trimmed to length + 1 bytes, which realloc usually does
+// in place, and the string builder is left empty
+// an inline string is copied to the heap first
+// length may be NULL
+// returns 0 if nothing goes wrong
+int string_builder_steal(struct string_builder_t *sb, char **str, 
+                         int *length) {
+        if (sb == NULL || str == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (sb->chars == NULL) {
+                *str = ds_alloc(sb->allocator, sb->count + 1);
+                if (*str == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                memcpy(*str, sb->inline_chars, sb->count);
+                DS__STATS_ADD(sb, memcpy_bytes, sb->count);
+        } else {
+                char *temp = ds_realloc(sb->allocator, sb->chars, 
+                                        sb->capacity, sb->count + 1);
+                *str = temp ? temp : sb->chars;
+
+                // the storage now belongs to the caller
+                DS__STATS_ADD(sb, frees, 1);
+                DS__STATS_ADD(sb, live_bytes, -(long long)sb->capacity);
+        }
+        (*str)[sb->count] = 0;
+        if (length != NULL) {
+                *length = sb->count;
+        }
+
+        sb->chars = NULL;
+        sb->count = 0;
+        sb->capacity = DS_STRING_BUILDER_INLINE;
+        return DS_NO_ERROR;
+}
+
+// delete the string builder
+int string_builder_delete(struct string_builder_t *sb) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (sb->chars != NULL) {
+                DS__FREE(sb, sb->chars, sb->capacity);
+        }
+        sb->chars = NULL;
+        sb->count = 0;
+        sb->capacity = DS_STRING_BUILDER_INLINE;
+
+        return DS_NO_ERROR;
+}
+
+// get the counters of the string builder
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int string_builder_stats(struct string_builder_t *sb, 
+                         struct ds_stats_t *stats) {
+        if (sb == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = sb->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// get the character at a given index
+// 
+// returns 0 if nothing goes wrong
+int string_builder_get(struct string_builder_t *sb, int index, char *ch) {
+        if (sb == NULL || ch == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= sb->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        *ch = ds__string_builder_chars(sb)[index];
+        return DS_NO_ERROR;
+}
+
+// set the character at a given index
+//
+// returns 0 if nothing goes wrong
+int string_builder_set(struct string_builder_t *sb, int index, char ch) {
+        if (sb == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (index < 0 || index >= sb->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        ds__string_builder_chars(sb)[index] = ch;
+        return DS_NO_ERROR;
+}
+
+// find the first occurrence of a string at or after start
+//
+// returns 0 and sets index if found
+// returns DS_NOT_FOUND_ERROR otherwise
+int string_builder_find(struct string_builder_t *sb, const char *needle,
+                        int start, int *index) {
+        if (sb == NULL || needle == NULL || index == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (start < 0 || start > sb->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        size_t n = sb->count - start;
+        size_t offset = ds__find_bytes(ds__string_builder_chars(sb) + start,
+                                       n, needle, strlen(needle));
+        if (offset >= n && !(needle[0] == 0 && offset == 0)) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        *index = start + (int)offset;
+        return DS_NO_ERROR;
+}
+
+// find the first occurrence of a character at or after start
+//
+// returns 0 and sets index if found
+// returns DS_NOT_FOUND_ERROR otherwise
+int string_builder_find_char(struct string_builder_t *sb, char ch, 
+                             int start, int *index) {
+        if (sb == NULL || index == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (start < 0 || start > sb->count) {
+                return DS_RANGE_ERROR;
+        }
+
+        size_t n = sb->count - start;
+        size_t offset = ds__find_byte(ds__string_builder_chars(sb) + start, 
+                                      n, ch);
+        if (offset >= n) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        *index = start + (int)offset;
+        return DS_NO_ERROR;
+}
+
+// count the occurrences of a character
+//
+// returns 0 if nothing went wrong
+int string_builder_count_char(struct string_builder_t *sb, char ch, 
+                              int *count) {
+        if (sb == NULL || count == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        *count = (int)ds__count_byte(ds__string_builder_chars(sb), 
+                                     sb->count, ch);
+        return DS_NO_ERROR;
+}
+
+// replace every occurrence of from with to
+//
+// occurrences are found left to right and do not overlap
+// the string is rewritten in place when it does not grow, otherwise it
+// is assembled once into new storage
+// replaced may be NULL
+// returns 0 if nothing went wrong
+int string_builder_replace(struct string_builder_t *sb, const char *from,
+                           const char *to, int *replaced) {
+        if (sb == NULL || from == NULL || to == NULL || from[0] == 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        size_t from_len = strlen(from);
+        size_t to_len = strlen(to);
+        char *chars = ds__string_builder_chars(sb);
+        size_t n = sb->count;
+
+        // count first, so growing needs exactly one allocation
+        int matches = 0;
+        for (size_t i = ds__find_bytes(chars, n, from, from_len); i < n;
+             i = i + from_len + ds__find_bytes(chars + i + from_len, 
+                                               n - i - from_len, from, 
+                                               from_len)) {
+                matches++;
+        }
+        if (replaced != NULL) {
+                *replaced = matches;
+        }
+        if (matches == 0) {
+                return DS_NO_ERROR;
+        }
+
+        long long new_count = (long long)n + 
+                              (long long)matches * ((long long)to_len - 
+                                                    (long long)from_len);
+        if (new_count > INT_MAX - 1) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        char inline_chars[DS_STRING_BUILDER_INLINE];
+        char *out = chars;
+        int new_capacity = sb->capacity;
+        if (to_len > from_len) {
+                if (sb->chars == NULL && 
+                    new_count < DS_STRING_BUILDER_INLINE) {
+                        out = inline_chars;
+                } else {
+                        new_capacity = (int)new_count + 1;
+                        out = DS__ALLOC(sb, new_capacity);
+                        if (out == NULL) {
+                                return DS_MALLOC_ERROR;
+                        }
+                }
+        }
+
+        // when writing in place the output never overtakes the input
+        size_t read = 0, write = 0;
+        for (int k = 0; k < matches; k++) {
+                size_t i = read + ds__find_bytes(chars + read, n - read, 
+                                                 from, from_len);
+                memmove(out + write, chars + read, i - read);
+                write += i - read;
+                memcpy(out + write, to, to_len);
+                write += to_len;
+                read = i + from_len;
+        }
+        memmove(out + write, chars + read, n - read);
+        DS__STATS_ADD(sb, memcpy_bytes, new_count);
+
+        if (out == inline_chars) {
+                memcpy(sb->inline_chars, inline_chars, new_count);
+        } else if (out != chars) {
+                if (sb->chars != NULL) {
+                        DS__FREE(sb, sb->chars, sb->capacity);
+                }
+                sb->chars = out;
+                sb->capacity = new_capacity;
+        }
+        sb->count = (int)new_count;
+        return DS_NO_ERROR;
+}
+
+// split the string at every delimiter
+//
+// parts must be a vector of fixed size struct string_view_t items, one
+// view is appended per part (empty parts included), the views point into
+// the string builder and are valid until it is changed or moved
+// returns 0 if nothing went wrong
+int string_builder_split(struct string_builder_t *sb, char delimiter,
+                         struct vector_t *parts) {
+        if (sb == NULL || parts == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (parts->stride != sizeof(struct string_view_t)) {
+                return DS_SIZE_ERROR;
+        }
+
+        const char *chars = ds__string_builder_chars(sb);
+        size_t n = sb->count;
+        int err = vector_reserve(parts, parts->count + 1 + 
+                                 (int)ds__count_byte(chars, n, delimiter));
+        if (err) {
+                return err;
+        }
+
+        size_t start = 0;
+        for (;;) {
+                size_t end = start + ds__find_byte(chars + start, n - start,
+                                                   delimiter);
+                struct string_view_t view = { chars + start, 
+                                              (int)(end - start) };
+                err = vector_append(parts, &view, sizeof(view));
+                if (err) {
+                        return err;
+                }
+                if (end >= n) {
+                        break;
+                }
+                start = end + 1;
+        }
+        return DS_NO_ERROR;
+}
+
+// a segment of the rope builder, the characters follow the header
+struct ds__rope_segment_t {
+        struct ds__rope_segment_t *next;
+        int used;
+};
+
+static char *ds__rope_segment_data(struct ds__rope_segment_t *segment) {
+        return (char *)(segment + 1);
+}
+
+static size_t ds__rope_segment_bytes(struct rope_builder_t *rope) {
+        return sizeof(struct ds__rope_segment_t) + rope->segment_size;
+}
+
+// initialize the rope builder
+//
+// segment_size 0 means DS_ROPE_BUILDER_SEGMENT
+// returns 0 if no error
+int rope_builder_init(struct rope_builder_t *rope, int segment_size) {
+        return rope_builder_init_alloc(rope, segment_size, NULL);
+}
+
+// initialize the rope builder with a custom allocator
+//
+// returns 0 if no error
+int rope_builder_init_alloc(struct rope_builder_t *rope, int segment_size,
+                            const struct ds_allocator_t *allocator) {
+        if (rope == NULL || segment_size < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        rope->head = NULL;
+        rope->tail = NULL;
+        rope->spare = NULL;
+        rope->segment_size = segment_size ? segment_size : 
+                                            DS_ROPE_BUILDER_SEGMENT;
+        rope->length = 0;
+        rope->buffered = 0;
+        rope->flush_threshold = 0;
+        rope->file = NULL;
+        rope->fd = -1;
+        rope->allocator = allocator;
+        DS__STATS_INIT(rope);
+        return DS_NO_ERROR;
+}
+
+// flush to a file descriptor whenever flush_threshold bytes are buffered
+//
+// flush_threshold 0 means only rope_builder_flush writes
+// returns 0 if no error
+int rope_builder_set_fd(struct rope_builder_t *rope, int fd, 
+                        long long flush_threshold) {
+        if (rope == NULL || fd < 0 || flush_threshold < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        rope->fd = fd;
+        rope->file = NULL;
+        rope->flush_threshold = flush_threshold;
+        return DS_NO_ERROR;
+}
+
+// flush to a file whenever flush_threshold bytes are buffered
+//
+// flush_threshold 0 means only rope_builder_flush writes
+// returns 0 if no error
+int rope_builder_set_file(struct rope_builder_t *rope, FILE *file,
+                          long long flush_threshold) {
+        if (rope == NULL || file == NULL || flush_threshold < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        rope->file = file;
+        rope->fd = -1;
+        rope->flush_threshold = flush_threshold;
+        return DS_NO_ERROR;
+}
+
+// start a new tail segment, reusing a flushed one if there is any
+//
+// returns 0 if no error
+static int ds__rope_builder_add_segment(struct rope_builder_t *rope) {
+        struct ds__rope_segment_t *segment = rope->spare;
+        if (segment != NULL) {
+                rope->spare = segment->next;
+        } else {
+                segment = DS__ALLOC(rope, ds__rope_segment_bytes(rope));
+                if (segment == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                DS__STATS_ADD(rope, grows, 1);
+        }
+
+        segment->next = NULL;
+        segment->used = 0;
+        if (rope->tail != NULL) {
+                rope->tail->next = segment;
+        } else {
+                rope->head = segment;
+        }
+        rope->tail = segment;
+        return DS_NO_ERROR;
+}
+
+// drop the first written bytes from the buffered segments
+//
+// segments written out completely go to the spare list, a segment written
+// only in part keeps the rest at its start, so the next flush continues
+// right after the last byte that got out
+static void ds__rope_builder_consume(struct rope_builder_t *rope, 
+                                     size_t written) {
+        rope->buffered -= written;
+        while (rope->head != NULL && written >= (size_t)rope->head->used) {
+                struct ds__rope_segment_t *segment = rope->head;
+                written -= segment->used;
+                rope->head = segment->next;
+                if (rope->head == NULL) {
+                        rope->tail = NULL;
+                }
+                segment->next = rope->spare;
+                rope->spare = segment;
+        }
+        if (written > 0) {
+                char *data = ds__rope_segment_data(rope->head);
+                rope->head->used -= (int)written;
+                memmove(data, data + written, rope->head->used);
+                DS__STATS_ADD(rope, memcpy_bytes, rope->head->used);
+        }
+}
+
+// write every buffered segment to the descriptor with writev
+//
+// returns 0 if no error
+static int ds__rope_builder_writev(struct rope_builder_t *rope) {
+        struct iovec iov[64];
+
+        while (rope->head != NULL) {
+                int n = 0;
+                for (struct ds__rope_segment_t *segment = rope->head; 
+                     segment != NULL && n < 64; segment = segment->next) {
+                        if (segment->used > 0) {
+                                iov[n].iov_base = 
+                                        ds__rope_segment_data(segment);
+                                iov[n].iov_len = segment->used;
+                                n++;
+                        }
+                }
+                if (n == 0) {
+                        // only empty segments are left
+                        ds__rope_builder_consume(rope, 0);
+                        break;
+                }
+
+                // writev may write less than asked, continue from there
+                ssize_t written = writev(rope->fd, iov, n);
+                if (written < 0) {
+                        if (errno == EINTR) {
+                                continue;
+                        }
+                        return DS_IO_ERROR;
+                }
+                if (written == 0) {
+                        // no progress, retrying would spin forever
+                        return DS_IO_ERROR;
+                }
+                ds__rope_builder_consume(rope, written);
+        }
+        return DS_NO_ERROR;
+}
+
+// write everything buffered to the file or descriptor
+//
+// the segments are kept for reuse, what could not be written stays
+// buffered, so a flush that failed with DS_IO_ERROR (EAGAIN on a non
+// blocking descriptor, ...) can be retried without writing bytes twice
+// returns 0 if no error
+int rope_builder_flush(struct rope_builder_t *rope) {
+        if (rope == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (rope->file == NULL && rope->fd < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        if (rope->file == NULL) {
+                return ds__rope_builder_writev(rope);
+        }
+        while (rope->head != NULL) {
+                struct ds__rope_segment_t *segment = rope->head;
+                size_t size = segment->used;
+                size_t written = 0;
+                if (size > 0) {
+                        written = fwrite(ds__rope_segment_data(segment), 1,
+                                         size, rope->file);
+                }
+                ds__rope_builder_consume(rope, written);
+                if (written != size) {
+                        return DS_IO_ERROR;
+                }
+        }
+        return DS_NO_ERROR;
+}
+
+// flush if the threshold is reached
+static int ds__rope_builder_maybe_flush(struct rope_builder_t *rope) {
+        if (rope->flush_threshold > 0 && 
+            rope->buffered >= rope->flush_threshold) {
+                return rope_builder_flush(rope);
+        }
+        return DS_NO_ERROR;
+}
+
+// append len bytes
+//
+// returns 0 if no error
+int rope_builder_write(struct rope_builder_t *rope, const void *data, 
+                       long long len) {
+        if (rope == NULL || (data == NULL && len > 0) || len < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        const char *bytes = data;
+        while (len > 0) {
+                if (rope->tail == NULL || 
+                    rope->tail->used == rope->segment_size) {
+                        int err = ds__rope_builder_add_segment(rope);
+                        if (err) {
+                                return err;
+                        }
+                }
+
+                int room = rope->segment_size - rope->tail->used;
+                int n = len < room ? (int)len : room;
+                memcpy(ds__rope_segment_data(rope->tail) + rope->tail->used,
+                       bytes, n);
+                DS__STATS_ADD(rope, memcpy_bytes, n);
+                rope->tail->used += n;
+                rope->length += n;
+                rope->buffered += n;
+                bytes += n;
+                len -= n;
+        }
+
+        return ds__rope_builder_maybe_flush(rope);
+}
+
+// append a given string
+//
+// returns 0 if no error
+int rope_builder_append(struct rope_builder_t *rope, const char *str) {
+        if (str == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        return rope_builder_write(rope, str, strlen(str));
+}
+
+// append a given character
+//
+// returns 0 if no error
+int rope_builder_appendc(struct rope_builder_t *rope, char ch) {
+        if (rope == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (rope->tail != NULL && rope->tail->used < rope->segment_size) {
+                ds__rope_segment_data(rope->tail)[rope->tail->used++] = ch;
+                rope->length++;
+                rope->buffered++;
+                return ds__rope_builder_maybe_flush(rope);
+        }
+        return rope_builder_write(rope, &ch, 1);
+}
+
+// append a formated string like printf
+//
+// formats directly into the tail segment when it fits, otherwise into a
+// temporary buffer which is then written
+// returns 0 if no error
+int rope_builder_appendf(struct rope_builder_t *rope, const char *format,
+                         ...) {
+        if (rope == NULL || format == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        va_list args;
+        va_start(args, format);
+        int needed = vsnprintf(NULL, 0, format, args);
+        va_end(args);
+        if (needed < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        // vsnprintf also writes the terminator, which needs a byte of room
+        if (rope->tail != NULL && 
+            needed < rope->segment_size - rope->tail->used) {
+                va_start(args, format);
+                vsnprintf(ds__rope_segment_data(rope->tail) + 
+                          rope->tail->used, needed + 1, format, args);
+                va_end(args);
+                rope->tail->used += needed;
+                rope->length += needed;
+                rope->buffered += needed;
+                return ds__rope_builder_maybe_flush(rope);
+        }
+
+        char *buffer = DS__ALLOC(rope, needed + 1);
+        if (buffer == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        va_start(args, format);
+        vsnprintf(buffer, needed + 1, format, args);
+        va_end(args);
+
+        int err = rope_builder_write(rope, buffer, needed);
+        DS__FREE(rope, buffer, needed + 1);
+        return err;
+}
+
+// join the buffered segments into one null terminated string
+//
+// length may be NULL
+// returns 0 if no error
+int rope_builder_build(struct rope_builder_t *rope, char **str, 
+                       long long *length) {
+        if (rope == NULL || str == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if ((unsigned long long)rope->buffered + 1 > (size_t)-1) {
+                return DS_MALLOC_ERROR;
+        }
+
+        *str = ds_alloc(rope->allocator, rope->buffered + 1);
+        if (*str == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+
+        char *at = *str;
+        for (struct ds__rope_segment_t *segment = rope->head; 
+             segment != NULL; segment = segment->next) {
+                memcpy(at, ds__rope_segment_data(segment), segment->used);
+                at += segment->used;
+        }
+        *at = 0;
+        if (length != NULL) {
+                *length = rope->buffered;
+        }
+        return DS_NO_ERROR;
+}
+
+// free a list of segments
+static void ds__rope_builder_free_list(struct rope_builder_t *rope,
+                                       struct ds__rope_segment_t *segment) {
+        while (segment != NULL) {
+                struct ds__rope_segment_t *next = segment->next;
+                DS__FREE(rope, segment, ds__rope_segment_bytes(rope));
+                segment = next;
+        }
+}
+
+// delete the rope builder
+//
+// buffered data that was not flushed is dropped
+int rope_builder_delete(struct rope_builder_t *rope) {
+        if (rope == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        ds__rope_builder_free_list(rope, rope->head);
+        ds__rope_builder_free_list(rope, rope->spare);
+        rope->head = NULL;
+        rope->tail = NULL;
+        rope->spare = NULL;
+        rope->length = 0;
+        rope->buffered = 0;
+        return DS_NO_ERROR;
+}
+
+// get the counters of the rope builder
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int rope_builder_stats(struct rope_builder_t *rope, 
+                       struct ds_stats_t *stats) {
+        if (rope == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = rope->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// initialize the string interner
+//
+// returns 0 if no error
+int string_interner_init(struct string_interner_t *interner) {
+        return string_interner_init_alloc(interner, NULL);
+}
+
+// initialize the string interner with a custom allocator
+//
+// returns 0 if no error
+int string_interner_init_alloc(struct string_interner_t *interner,
+                               const struct ds_allocator_t *allocator) {
+        if (interner == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int err = ds_arena_init(&interner->arena, 0);
+        if (err) {
+                return err;
+        }
+        err = vector_init_alloc(&interner->strings, 
+                                sizeof(struct string_view_t), allocator);
+        if (err) {
+                return err;
+        }
+        return hash_map_init_alloc(&interner->ids, 
+                                   sizeof(struct string_view_t), 
+                                   sizeof(int), ds_hash_string_view, 
+                                   ds_equal_string_view, allocator);
+}
+
+// find the id of a string without adding it
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if the string was never interned
+int string_interner_lookup(struct string_interner_t *interner, 
+                           const char *str, int length, int *id) {
+        if (interner == NULL || (str == NULL && length > 0) || length < 0 ||
+            id == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        struct string_view_t key = { str, length };
+        int *found = hash_map_find(&interner->ids, &key);
+        if (found == NULL) {
+                return DS_NOT_FOUND_ERROR;
+        }
+        *id = *found;
+        return DS_NO_ERROR;
+}
+
+// get the id of the first length characters of str, adding them if new
+//
+// str does not need to be NUL terminated
+// returns 0 if no error
+int string_interner_internn(struct string_interner_t *interner, 
+                            const char *str, int length, int *id) {
+        int err = string_interner_lookup(interner, str, length, id);
+        if (err != DS_NOT_FOUND_ERROR) {
+                return err;
+        }
+
+        char *copy = ds_arena_alloc_bytes(&interner->arena, 
+                                          (size_t)length + 1);
+        if (copy == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        if (length > 0) {
+                memcpy(copy, str, length);
+        }
+        copy[length] = '\0';
+
+        // the arena bytes are not given back on failure, the next reset
+        // or delete frees them
+        struct string_view_t view = { copy, length };
+        int new_id = interner->strings.count;
+        err = vector_append(&interner->strings, &view, sizeof(view));
+        if (err) {
+                return err;
+        }
+        err = hash_map_put(&interner->ids, &view, &new_id);
+        if (err) {
+                vector_pop(&interner->strings);
+                return err;
+        }
+        *id = new_id;
+        return DS_NO_ERROR;
+}
+
+// get the id of a NUL terminated string, adding it if new
+//
+// returns 0 if no error
+int string_interner_intern(struct string_interner_t *interner, 
+                           const char *str, int *id) {
+        if (str == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        size_t length = strlen(str);
+        if (length > INT_MAX) {
+                return DS_SIZE_ERROR;
+        }
+        return string_interner_internn(interner, str, (int)length, id);
+}
+
+// get the string with the given id
+//
+// view->data is NUL terminated
+// returns 0 if no error
+// returns DS_RANGE_ERROR if there is no such id
+int string_interner_get(struct string_interner_t *interner, int id,
+                        struct string_view_t *view) {
+        if (interner == NULL || view == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        return vector_get(&interner->strings, id, view, sizeof(*view));
+}
+
+// get the number of distinct strings
+//
+// returns 0 if no error
+int string_interner_count(struct string_interner_t *interner, int *count) {
+        if (interner == NULL || count == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        *count = interner->strings.count;
+        return DS_NO_ERROR;
+}
+
+// delete the string interner
+//
+// frees all the strings at once, their views become invalid
+int string_interner_delete(struct string_interner_t *interner) {
+        if (interner == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        hash_map_delete(&interner->ids);
+        vector_delete(&interner->strings);
+        return ds_arena_delete(&interner->arena);
+}
+
+#ifdef DS__HAS_ATOMICS
+
+// round capacity up to a power of two
+//
+// returns 0 if capacity is not positive or too large
+static size_t ds__queue_capacity(int capacity) {
+        if (capacity <= 0 || capacity > (INT_MAX >> 1) + 1) {
+                return 0;
+        }
+        size_t rounded = 1;
+        while (rounded < (size_t)capacity) {
+                rounded <<= 1;
+        }
+        return rounded;
+}
+
+// initialize the spsc queue
+//
+// returns 0 if no error
+int spsc_queue_init(struct spsc_queue_t *queue, int capacity, 
+                    int item_size) {
+        return spsc_queue_init_alloc(queue, capacity, item_size, NULL);
+}
+
+// initialize the spsc queue with a custom allocator
+//
+// the items are allocated up front
+// returns 0 if no error
+int spsc_queue_init_alloc(struct spsc_queue_t *queue, int capacity,
+                          int item_size, 
+                          const struct ds_allocator_t *allocator) {
+        size_t rounded = ds__queue_capacity(capacity);
+        if (queue == NULL || rounded == 0 || item_size <= 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        queue->allocator = allocator;
+        DS__STATS_INIT(queue);
+        queue->items = DS__ALLOC(queue, rounded * item_size);
+        if (queue->items == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        atomic_init(&queue->head, 0);
+        atomic_init(&queue->tail, 0);
+        queue->cached_head = 0;
+        queue->cached_tail = 0;
+        queue->mask = rounded - 1;
+        queue->item_size = item_size;
+        return DS_NO_ERROR;
+}
+
+// copy count items into the ring starting at position pos
+static void ds__queue_copy_in(char *ring, size_t mask, int item_size, 
+                              size_t pos, const char *items, size_t count) {
+        size_t start = pos & mask;
+        size_t first = mask + 1 - start;
+        if (first > count) {
+                first = count;
+        }
+        memcpy(ring + start * item_size, items, first * item_size);
+        memcpy(ring, items + first * item_size, (count - first) * item_size);
+}
+
+// copy count items out of the ring starting at position pos
+static void ds__queue_copy_out(const char *ring, size_t mask, int item_size,
+                               size_t pos, char *items, size_t count) {
+        size_t start = pos & mask;
+        size_t first = mask + 1 - start;
+        if (first > count) {
+                first = count;
+        }
+        memcpy(items, ring + start * item_size, first * item_size);
+        memcpy(items + first * item_size, ring, (count - first) * item_size);
+}
+
+// push up to count items, only from the producer thread
+//
+// the tail is published once for the whole batch
+// pushed may be NULL
+// returns 0 if at least one item was pushed
+// returns DS_FULL_ERROR if there was no room at all
+int spsc_queue_push_many(struct spsc_queue_t *queue, const void *items,
+                         int count, int size, int *pushed) {
+        if (queue == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->item_size) {
+                return DS_SIZE_ERROR;
+        }
+
+        size_t capacity = queue->mask + 1;
+        size_t tail = atomic_load_explicit(&queue->tail, 
+                                           memory_order_relaxed);
+        size_t room = capacity - (tail - queue->cached_head);
+        if (room < (size_t)count) {
+                queue->cached_head = atomic_load_explicit(
+                        &queue->head, memory_order_acquire);
+                room = capacity - (tail - queue->cached_head);
+        }
+
+        size_t n = room < (size_t)count ? room : (size_t)count;
+        if (pushed != NULL) {
+                *pushed = (int)n;
+        }
+        if (n == 0) {
+                return count == 0 ? DS_NO_ERROR : DS_FULL_ERROR;
+        }
+
+        ds__queue_copy_in(queue->items, queue->mask, size, tail, items, n);
+        atomic_store_explicit(&queue->tail, tail + n, memory_order_release);
+        return DS_NO_ERROR;
+}
+
+// push an item, only from the producer thread
+//
+// returns 0 if no error
+// returns DS_FULL_ERROR if the queue is full
+int spsc_queue_push(struct spsc_queue_t *queue, const void *item, 
+                    int size) {
+        return spsc_queue_push_many(queue, item, 1, size, NULL);
+}
+
+// pop up to count items, only from the consumer thread
+//
+// the head is published once for the whole batch
+// popped may be NULL
+// returns 0 if at least one item was popped
+// returns DS_EMPTY_ERROR if there was nothing
+int spsc_queue_pop_many(struct spsc_queue_t *queue, void *items, int count,
+                        int size, int *popped) {
+        if (queue == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->item_size) {
+                return DS_SIZE_ERROR;
+        }
+
+        size_t head = atomic_load_explicit(&queue->head, 
+                                           memory_order_relaxed);
+        size_t available = queue->cached_tail - head;
+        if (available < (size_t)count) {
+                queue->cached_tail = atomic_load_explicit(
+                        &queue->tail, memory_order_acquire);
+                available = queue->cached_tail - head;
+        }
+
+        size_t n = available < (size_t)count ? available : (size_t)count;
+        if (popped != NULL) {
+                *popped = (int)n;
+        }
+        if (n == 0) {
+                return count == 0 ? DS_NO_ERROR : DS_EMPTY_ERROR;
+        }
+
+        ds__queue_copy_out(queue->items, queue->mask, size, head, items, n);
+        atomic_store_explicit(&queue->head, head + n, memory_order_release);
+        return DS_NO_ERROR;
+}
+
+// pop an item, only from the consumer thread
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the queue is empty
+int spsc_queue_pop(struct spsc_queue_t *queue, void *item, int size) {
+        return spsc_queue_pop_many(queue, item, 1, size, NULL);
+}
+
+// delete the spsc queue
+//
+// no thread may use the queue anymore
+int spsc_queue_delete(struct spsc_queue_t *queue) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        DS__FREE(queue, queue->items, (queue->mask + 1) * queue->item_size);
+        queue->items = NULL;
+        return DS_NO_ERROR;
+}
+
+// get the counters of the spsc queue
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int spsc_queue_stats(struct spsc_queue_t *queue, struct ds_stats_t *stats) {
+        if (queue == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = queue->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+static atomic_size_t *ds__mpsc_sequence(struct mpsc_queue_t *queue, 
+                                        size_t pos) {
+        return (atomic_size_t *)(queue->slots + 
+                                 (pos & queue->mask) * queue->slot_size);
+}
+
+static char *ds__mpsc_item(struct mpsc_queue_t *queue, size_t pos) {
+        return queue->slots + (pos & queue->mask) * queue->slot_size + 
+               sizeof(atomic_size_t);
+}
+
+// initialize the mpsc queue
+//
+// returns 0 if no error
+int mpsc_queue_init(struct mpsc_queue_t *queue, int capacity, 
+                    int item_size) {
+        return mpsc_queue_init_alloc(queue, capacity, item_size, NULL);
+}
+
+// initialize the mpsc queue with a custom allocator
+//
+// every slot starts with its sequence number, equal to its position when
+// it is free and to position + 1 when it holds an item
+// returns 0 if no error
+int mpsc_queue_init_alloc(struct mpsc_queue_t *queue, int capacity,
+                          int item_size, 
+                          const struct ds_allocator_t *allocator) {
+        size_t rounded = ds__queue_capacity(capacity);
+        if (queue == NULL || rounded == 0 || item_size <= 0 ||
+            item_size > INT_MAX / 2) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        int align = sizeof(atomic_size_t);
+        queue->slot_size = (sizeof(atomic_size_t) + item_size + align - 1) /
+                           align * align;
+        queue->allocator = allocator;
+        DS__STATS_INIT(queue);
+        queue->slots = DS__ALLOC(queue, rounded * queue->slot_size);
+        if (queue->slots == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        queue->mask = rounded - 1;
+        queue->item_size = item_size;
+        for (size_t i = 0; i < rounded; i++) {
+                atomic_init(ds__mpsc_sequence(queue, i), i);
+        }
+        atomic_init(&queue->tail, 0);
+        queue->head = 0;
+        return DS_NO_ERROR;
+}
+
+// push up to count items, from any thread
+//
+// the whole batch is claimed with one compare and swap, if the queue
+// has less room the batch is halved until it fits
+// pushed may be NULL
+// returns 0 if at least one item was pushed
+// returns DS_FULL_ERROR if there was no room at all
+int mpsc_queue_push_many(struct mpsc_queue_t *queue, const void *items,
+                         int count, int size, int *pushed) {
+        if (queue == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->item_size) {
+                return DS_SIZE_ERROR;
+        }
+        if (pushed != NULL) {
+                *pushed = 0;
+        }
+        if (count == 0) {
+                return DS_NO_ERROR;
+        }
+
+        size_t n = (size_t)count;
+        if (n > queue->mask + 1) {
+                n = queue->mask + 1;
+        }
+        size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        for (;;) {
+                // slots are freed in order, so if the last one of the
+                // batch is free all of them are
+                size_t last = pos + n - 1;
+                size_t sequence = atomic_load_explicit(
+                        ds__mpsc_sequence(queue, last), memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)last;
+                if (diff == 0) {
+                        if (atomic_compare_exchange_weak_explicit(
+                                    &queue->tail, &pos, pos + n,
+                                    memory_order_relaxed, 
+                                    memory_order_relaxed)) {
+                                break;
+                        }
+                } else if (diff < 0) {
+                        if (n == 1) {
+                                return DS_FULL_ERROR;
+                        }
+                        n /= 2;
+                } else {
+                        pos = atomic_load_explicit(&queue->tail, 
+                                                   memory_order_relaxed);
+                }
+        }
+
+        const char *item = items;
+        for (size_t i = 0; i < n; i++, item += size) {
+                memcpy(ds__mpsc_item(queue, pos + i), item, size);
+                atomic_store_explicit(ds__mpsc_sequence(queue, pos + i), 
+                                      pos + i + 1, memory_order_release);
+        }
+        if (pushed != NULL) {
+                *pushed = (int)n;
+        }
+        return DS_NO_ERROR;
+}
+
+// push an item, from any thread
+//
+// returns 0 if no error
+// returns DS_FULL_ERROR if the queue is full
+int mpsc_queue_push(struct mpsc_queue_t *queue, const void *item, 
+                    int size) {
+        return mpsc_queue_push_many(queue, item, 1, size, NULL);
+}
+
+// pop up to count items, only from the consumer thread
+//
+// stops early at a slot that was claimed but is not written yet
+// popped may be NULL
+// returns 0 if at least one item was popped
+// returns DS_EMPTY_ERROR if there was nothing
+int mpsc_queue_pop_many(struct mpsc_queue_t *queue, void *items, int count,
+                        int size, int *popped) {
+        if (queue == NULL || (items == NULL && count > 0) || count < 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != queue->item_size) {
+                return DS_SIZE_ERROR;
+        }
+
+        char *item = items;
+        int n = 0;
+        for (; n < count; n++, item += size) {
+                size_t pos = queue->head;
+                atomic_size_t *sequence = ds__mpsc_sequence(queue, pos);
+                if (atomic_load_explicit(sequence, memory_order_acquire) != 
+                    pos + 1) {
+                        break;
+                }
+                memcpy(item, ds__mpsc_item(queue, pos), size);
+                atomic_store_explicit(sequence, pos + queue->mask + 1, 
+                                      memory_order_release);
+                queue->head = pos + 1;
+        }
+
+        if (popped != NULL) {
+                *popped = n;
+        }
+        if (n == 0 && count > 0) {
+                return DS_EMPTY_ERROR;
+        }
+        return DS_NO_ERROR;
+}
+
+// pop an item, only from the consumer thread
+//
+// returns 0 if no error
+// returns DS_EMPTY_ERROR if the queue is empty
+int mpsc_queue_pop(struct mpsc_queue_t *queue, void *item, int size) {
+        return mpsc_queue_pop_many(queue, item, 1, size, NULL);
+}
+
+// delete the mpsc queue
+//
+// no thread may use the queue anymore
+int mpsc_queue_delete(struct mpsc_queue_t *queue) {
+        if (queue == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        DS__FREE(queue, queue->slots, (queue->mask + 1) * queue->slot_size);
+        queue->slots = NULL;
+        return DS_NO_ERROR;
+}
+
+// get the counters of the mpsc queue
+//
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int mpsc_queue_stats(struct mpsc_queue_t *queue, struct ds_stats_t *stats) {
+        if (queue == NULL || stats == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+#ifdef DS_STATS
+        *stats = queue->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
+
+// find the block of an index and the position inside it
+//
+// block k holds the indices FIRST * (2^k - 1) up to FIRST * (2^(k+1) - 1)
+static void ds__segmented_vector_locate(int index, int *block, 
+                                        size_t *offset) {
+        size_t shifted = (size_t)index + DS_SEGMENTED_VECTOR_FIRST;
+        int log = 0;
+#if defined(__GNUC__)
+        log = (int)(sizeof(unsigned long long) * CHAR_BIT) - 1 - 
+              __builtin_clzll(shifted);
+#else
+        while (shifted >> (log + 1)) {
+                log++;
+        }
+#endif
+        int first_log = 0;
+        while ((1 << first_log) < DS_SEGMENTED_VECTOR_FIRST) {
+                first_log++;
+        }
+        *block = log - first_log;
+        *offset = shifted - ((size_t)1 << log);
+}
+
+static size_t ds__segmented_vector_block_items(int block) {
+        return (size_t)DS_SEGMENTED_VECTOR_FIRST << block;
+}
+
+// initialize the segmented vector
+//
+// returns 0 if no error
+int segmented_vector_init(struct segmented_vector_t *vector, int item_size) {
+        return segmented_vector_init_alloc(vector, item_size, NULL);
+}
+
+// initialize the segmented vector with a custom allocator
+//
+// no block is allocated until the first append
+// returns 0 if no error
+int segmented_vector_init_alloc(struct segmented_vector_t *vector, 
+                                int item_size,
+                                const struct ds_allocator_t *allocator) {
+        if (vector == NULL || item_size <= 0) {
+                return DS_ARGUMENT_ERROR;
+        }
+
+        for (int i = 0; i < DS__SEGMENTED_VECTOR_BLOCKS; i++) {
+                atomic_init(&vector->blocks[i], NULL);
+        }
+        atomic_init(&vector->count, 0);
+        vector->item_size = item_size;
+        vector->allocator = allocator;
+        DS__STATS_INIT(vector);
+        return DS_NO_ERROR;
+}
+
+// get the block, installing it if no thread did yet
+//
+// returns NULL if the allocation failed
+static char *ds__segmented_vector_block(struct segmented_vector_t *vector, 
+                                        int block) {
+        char *items = atomic_load_explicit(&vector->blocks[block], 
+                                           memory_order_acquire);
+        if (items != NULL) {
+                return items;
+        }
+
+        size_t size = ds__segmented_vector_block_items(block) * 
+                      vector->item_size;
+        char *fresh = DS__ALLOC(vector, size);
+        if (fresh == NULL) {
+                return NULL;
+        }
+        if (atomic_compare_exchange_strong_explicit(
+                    &vector->blocks[block], &items, fresh, 
+                    memory_order_acq_rel, memory_order_acquire)) {
+                return fresh;
+        }
+
+        // another thread won, items now holds its block
+        DS__FREE(vector, fresh, size);
+        return items;
+}
+
+// append an item, from any thread
+//
+// index may be NULL
+// returns 0 if no error
+// returns DS_FULL_ERROR if the vector already holds INT_MAX items
+// returns DS_MALLOC_ERROR if its block could not be allocated, the
+// reserved index is then lost
+int segmented_vector_append(struct segmented_vector_t *vector, 
+                            const void *item, int size, int *index) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != vector->item_size) {
+                return DS_SIZE_ERROR;
+        }
+
+        int reserved = atomic_fetch_add_explicit(&vector->count, 1, 
+                                                 memory_order_relaxed);
+        if (reserved < 0 || reserved == INT_MAX) {
+                return DS_FULL_ERROR;
+        }
+
+        int block;
+        size_t offset;
+        ds__segmented_vector_locate(reserved, &block, &offset);
+        char *items = ds__segmented_vector_block(vector, block);
+        if (items == NULL) {
+                return DS_MALLOC_ERROR;
+        }
+        memcpy(items + offset * size, item, size);
+        if (index != NULL) {
+                *index = reserved;
+        }
+        return DS_NO_ERROR;
+}
+
+// get a pointer to the item at index
+//
+// the pointer stays valid until the vector is deleted
+// returns 0 if no error
+// returns DS_RANGE_ERROR if the index was never reserved
+int segmented_vector_at(struct segmented_vector_t *vector, int index, 
+                        void **item) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        int count = atomic_load_explicit(&vector->count, 
+                                         memory_order_acquire);
+        if (index < 0 || (count >= 0 && index >= count)) {
+                return DS_RANGE_ERROR;
+        }
+
+        int block;
+        size_t offset;
+        ds__segmented_vector_locate(index, &block, &offset);
+        char *items = atomic_load_explicit(&vector->blocks[block], 
+                                           memory_order_acquire);
+        if (items == NULL) {
+                return DS_RANGE_ERROR;
+        }
+        *item = items + offset * vector->item_size;
+        return DS_NO_ERROR;
+}
+
+// copy the item at index into item
+//
+// returns 0 if no error
+// returns DS_RANGE_ERROR if the index was never reserved
+int segmented_vector_get(struct segmented_vector_t *vector, int index, 
+                         void *item, int size) {
+        if (vector == NULL || item == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (size != vector->item_size) {
+                return DS_SIZE_ERROR;
+        }
+
+        void *at;
+        int err = segmented_vector_at(vector, index, &at);
+        if (err != DS_NO_ERROR) {
+                return err;
+        }
+        memcpy(item, at, size);
+        return DS_NO_ERROR;
+}
+
+// get the number of reserved items
+//
+// returns 0 if no error
+int segmented_vector_count(struct segmented_vector_t *vector, int *count) {
+        if (vector == NULL || count == NULL) {
+                return DS_ARGUMENT_ERROR;
         }
 
-        va_start(args, format);
-        vsnprintf(buffer, needed + 1, format, args);
-        va_end(args);
+        int reserved = atomic_load_explicit(&vector->count, 
+                                            memory_order_relaxed);
+        *count = reserved < 0 ? INT_MAX : reserved;
+        return DS_NO_ERROR;
+}
 
-        for (int i = 0; i < needed + 1; i++) {
-                int err = vector_append(&sb->chars, (void *)&buffer[i], 
-                                        sizeof(char));
-                if (err) {
-                        return err;
-                }
+// delete the segmented vector
+//
+// no thread may use the vector anymore
+int segmented_vector_delete(struct segmented_vector_t *vector) {
+        if (vector == NULL) {
+                return DS_ARGUMENT_ERROR;
         }
-        free(buffer);
 
+        for (int i = 0; i < DS__SEGMENTED_VECTOR_BLOCKS; i++) {
+                char *items = atomic_load_explicit(&vector->blocks[i], 
+                                                   memory_order_relaxed);
+                if (items != NULL) {
+                        DS__FREE(vector, items, 
+                                 ds__segmented_vector_block_items(i) * 
+                                 vector->item_size);
+                }
+                atomic_init(&vector->blocks[i], NULL);
+        }
+        atomic_init(&vector->count, 0);
         return DS_NO_ERROR;
 }
 
-// append a given string n times
+// get the counters of the segmented vector
 //
-// returns 0 if nothing went wrong
-// returns -1 if something went wrong
-int string_builder_appendn(struct string_builder_t *sb, const char *str,
-                           int len) {
-        if (sb == NULL || str == NULL) {
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int segmented_vector_stats(struct segmented_vector_t *vector, 
+                           struct ds_stats_t *stats) {
+        if (vector == NULL || stats == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
+#ifdef DS_STATS
+        *stats = vector->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
+}
 
-        for (int i = 0; i < len; i++) {
-                for (int j = 0; str[j]; j++) {
-                        int err = vector_append(&sb->chars, (void*)&str[j], 
-                                                sizeof(char));
-                        if (err) {
-                                return err;
-                        }
+#endif // DS__HAS_ATOMICS
+
+// word kernels for the bitset
+//
+// ds__popcount_words and ds__bitset_words pick avx2, then popcnt (for
+// counting), then a portable loop, from the cached cpu checks
+#define DS__BITSET_WORD_BITS 64
+
+enum ds__bitset_op_enum {
+        DS__BITSET_AND,
+        DS__BITSET_OR,
+        DS__BITSET_XOR,
+        DS__BITSET_ANDNOT,
+};
+
+static int ds__popcount64(uint64_t x) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(x);
+#else
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static int ds__ctz64(uint64_t x) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#else
+        int n = 0;
+        while (!(x & 1)) {
+                x >>= 1;
+                n++;
+        }
+        return n;
+#endif
+}
+
+static size_t ds__popcount_words_scalar(const uint64_t *words, size_t n) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+                count += ds__popcount64(words[i]);
+        }
+        return count;
+}
+
+static void ds__bitset_words_scalar(uint64_t *dst, const uint64_t *src, 
+                                    size_t n, enum ds__bitset_op_enum op) {
+        switch (op) {
+        case DS__BITSET_AND:
+                for (size_t i = 0; i < n; i++) {
+                        dst[i] &= src[i];
+                }
+                break;
+        case DS__BITSET_OR:
+                for (size_t i = 0; i < n; i++) {
+                        dst[i] |= src[i];
                 }
+                break;
+        case DS__BITSET_XOR:
+                for (size_t i = 0; i < n; i++) {
+                        dst[i] ^= src[i];
+                }
+                break;
+        case DS__BITSET_ANDNOT:
+                for (size_t i = 0; i < n; i++) {
+                        dst[i] &= ~src[i];
+                }
+                break;
         }
+}
 
-        return DS_NO_ERROR;
+#ifdef DS__X86_DISPATCH
+// cached like ds__cpu_has_avx2
+static int ds__cpu_has_popcnt(void) {
+        static int has_popcnt = -1;
+        int has = __atomic_load_n(&has_popcnt, __ATOMIC_RELAXED);
+        if (has < 0) {
+                __builtin_cpu_init();
+                has = __builtin_cpu_supports("popcnt") != 0;
+                __atomic_store_n(&has_popcnt, has, __ATOMIC_RELAXED);
+        }
+        return has;
 }
 
-// append a given string
+__attribute__((target("popcnt")))
+static size_t ds__popcount_words_popcnt(const uint64_t *words, size_t n) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; i++) {
+                count += __builtin_popcountll(words[i]);
+        }
+        return count;
+}
+
+// nibble lookup with pshufb, byte counts are summed with psadbw
+__attribute__((target("avx2")))
+static size_t ds__popcount_words_avx2(const uint64_t *words, size_t n) {
+        const __m256i lookup = _mm256_setr_epi8(
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low_mask = _mm256_set1_epi8(0x0f);
+        __m256i sums = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+                __m256i block = 
+                        _mm256_loadu_si256((const __m256i *)(words + i));
+                __m256i low = _mm256_and_si256(block, low_mask);
+                __m256i high = _mm256_and_si256(_mm256_srli_epi16(block, 4),
+                                                low_mask);
+                __m256i bytes = _mm256_add_epi8(
+                        _mm256_shuffle_epi8(lookup, low),
+                        _mm256_shuffle_epi8(lookup, high));
+                sums = _mm256_add_epi64(
+                        sums, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+        }
+        size_t count = (size_t)_mm256_extract_epi64(sums, 0) + 
+                       (size_t)_mm256_extract_epi64(sums, 1) +
+                       (size_t)_mm256_extract_epi64(sums, 2) +
+                       (size_t)_mm256_extract_epi64(sums, 3);
+        return count + ds__popcount_words_scalar(words + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void ds__bitset_words_avx2(uint64_t *dst, const uint64_t *src, 
+                                  size_t n, enum ds__bitset_op_enum op) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+                __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+                switch (op) {
+                case DS__BITSET_AND:
+                        a = _mm256_and_si256(a, b);
+                        break;
+                case DS__BITSET_OR:
+                        a = _mm256_or_si256(a, b);
+                        break;
+                case DS__BITSET_XOR:
+                        a = _mm256_xor_si256(a, b);
+                        break;
+                case DS__BITSET_ANDNOT:
+                        a = _mm256_andnot_si256(b, a);
+                        break;
+                }
+                _mm256_storeu_si256((__m256i *)(dst + i), a);
+        }
+        ds__bitset_words_scalar(dst + i, src + i, n - i, op);
+}
+#endif
+
+// number of set bits in the n words
+static size_t ds__popcount_words(const uint64_t *words, size_t n) {
+#ifdef DS__X86_DISPATCH
+        if (ds__cpu_has_avx2()) {
+                return ds__popcount_words_avx2(words, n);
+        }
+        if (ds__cpu_has_popcnt()) {
+                return ds__popcount_words_popcnt(words, n);
+        }
+#endif
+        return ds__popcount_words_scalar(words, n);
+}
+
+// dst = dst op src for the n words
+static void ds__bitset_words(uint64_t *dst, const uint64_t *src, size_t n,
+                             enum ds__bitset_op_enum op) {
+#ifdef DS__X86_DISPATCH
+        if (ds__cpu_has_avx2()) {
+                ds__bitset_words_avx2(dst, src, n, op);
+                return;
+        }
+#endif
+        ds__bitset_words_scalar(dst, src, n, op);
+}
+
+static size_t ds__bitset_word_count(size_t bits) {
+        return (bits + DS__BITSET_WORD_BITS - 1) / DS__BITSET_WORD_BITS;
+}
+
+// initialize the bitset
 //
-// returns 0 if nothing went wrong
-int string_builder_append(struct string_builder_t *sb, const char *str) {
-        return string_builder_appendn(sb, str, 1);
+// returns 0 if no error
+int bitset_init(struct bitset_t *bitset) {
+        return bitset_init_alloc(bitset, NULL);
 }
 
-// append a given character
-// 
-// return 0 if nothing went wrong
-int string_builder_appendc(struct string_builder_t *sb, char ch) {
-        return vector_append(&sb->chars, (void*)&ch, sizeof(char));
+// initialize the bitset with a custom allocator
+//
+// nothing is allocated until the bitset grows
+// returns 0 if no error
+int bitset_init_alloc(struct bitset_t *bitset, 
+                      const struct ds_allocator_t *allocator) {
+        if (bitset == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        bitset->words = NULL;
+        bitset->count = 0;
+        bitset->capacity = 0;
+        bitset->allocator = allocator;
+        DS__STATS_INIT(bitset);
+        return DS_NO_ERROR;
 }
 
-// append a given character n times
+// change the number of bits
 //
-// returns 0 if nothing went wrong
-int string_builder_appendcn(struct string_builder_t *sb, char ch, int len) {
-        if (sb == NULL) {
+// new bits are 0, the words are doubled when they run out
+// returns 0 if no error
+int bitset_resize(struct bitset_t *bitset, size_t count) {
+        if (bitset == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
 
-        for (int i = 0; i < len; i++) {
-                int err = vector_append(&sb->chars, (void*)&ch, sizeof(char));
+        size_t used = ds__bitset_word_count(bitset->count);
+        size_t needed = ds__bitset_word_count(count);
+        if (needed > bitset->capacity) {
+                size_t capacity = bitset->capacity * 2;
+                capacity = capacity > needed ? capacity : needed;
+                uint64_t *words = DS__REALLOC(bitset, bitset->words,
+                                              bitset->capacity * 
+                                              sizeof(uint64_t),
+                                              capacity * sizeof(uint64_t));
+                if (words == NULL) {
+                        return DS_MALLOC_ERROR;
+                }
+                DS__STATS_ADD(bitset, grows, 1);
+                bitset->words = words;
+                bitset->capacity = capacity;
+        }
+
+        if (needed > used) {
+                memset(bitset->words + used, 0, 
+                       (needed - used) * sizeof(uint64_t));
+        }
+        bitset->count = count;
+
+        // keep the bits past the end 0 so whole words can be counted
+        size_t tail = count % DS__BITSET_WORD_BITS;
+        if (tail != 0) {
+                bitset->words[needed - 1] &= ((uint64_t)1 << tail) - 1;
+        }
+        return DS_NO_ERROR;
+}
+
+// set a bit to 1, growing the bitset if needed
+//
+// returns 0 if no error
+int bitset_set(struct bitset_t *bitset, size_t bit) {
+        if (bitset == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (bit >= bitset->count) {
+                int err = bitset_resize(bitset, bit + 1);
                 if (err) {
                         return err;
                 }
         }
+
+        bitset->words[bit / DS__BITSET_WORD_BITS] |= 
+                (uint64_t)1 << (bit % DS__BITSET_WORD_BITS);
         return DS_NO_ERROR;
 }
 
-// build the string and allocate the string to the provided pointer
+// set a bit to 0
 //
-// returns 0 if nothing goes wrong
-int string_builder_build(struct string_builder_t *sb, char **str) {
-        if (sb == NULL || str == NULL) { 
+// bits past the end are 0 already
+// returns 0 if no error
+int bitset_clear(struct bitset_t *bitset, size_t bit) {
+        if (bitset == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
+        if (bit < bitset->count) {
+                bitset->words[bit / DS__BITSET_WORD_BITS] &= 
+                        ~((uint64_t)1 << (bit % DS__BITSET_WORD_BITS));
+        }
+        return DS_NO_ERROR;
+}
 
-        *str = malloc(sizeof(char) * sb->chars.count + 1);
-        if (str == NULL) {
-                return DS_MALLOC_ERROR;
+// read a bit into value as 0 or 1
+//
+// returns 0 if no error
+int bitset_test(struct bitset_t *bitset, size_t bit, int *value) {
+        if (bitset == NULL || value == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (bit >= bitset->count) {
+                *value = 0;
+                return DS_NO_ERROR;
+        }
+
+        *value = (bitset->words[bit / DS__BITSET_WORD_BITS] >> 
+                  (bit % DS__BITSET_WORD_BITS)) & 1;
+        return DS_NO_ERROR;
+}
+
+// set every bit to 0, the size stays the same
+//
+// returns 0 if no error
+int bitset_clear_all(struct bitset_t *bitset) {
+        if (bitset == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (bitset->count > 0) {
+                memset(bitset->words, 0, 
+                       ds__bitset_word_count(bitset->count) * 
+                       sizeof(uint64_t));
+        }
+        return DS_NO_ERROR;
+}
+
+// count the bits that are 1
+//
+// returns 0 if no error
+int bitset_count(struct bitset_t *bitset, size_t *count) {
+        if (bitset == NULL || count == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        *count = ds__popcount_words(bitset->words, 
+                                    ds__bitset_word_count(bitset->count));
+        return DS_NO_ERROR;
+}
+
+// count the bits that are 1 before the given bit
+//
+// bit may be past the end, then every bit is counted
+// returns 0 if no error
+int bitset_rank(struct bitset_t *bitset, size_t bit, size_t *rank) {
+        if (bitset == NULL || rank == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (bit >= bitset->count) {
+                return bitset_count(bitset, rank);
+        }
+
+        size_t word = bit / DS__BITSET_WORD_BITS;
+        size_t count = ds__popcount_words(bitset->words, word);
+        uint64_t mask = ((uint64_t)1 << (bit % DS__BITSET_WORD_BITS)) - 1;
+        *rank = count + ds__popcount64(bitset->words[word] & mask);
+        return DS_NO_ERROR;
+}
+
+// find the first bit that is 1 at or after from
+//
+// returns 0 if no error
+// returns DS_NOT_FOUND_ERROR if there is none
+int bitset_find_next_set(struct bitset_t *bitset, size_t from, size_t *bit) {
+        if (bitset == NULL || bit == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (from >= bitset->count) {
+                return DS_NOT_FOUND_ERROR;
         }
 
-        for (int i = 0; i < sb->chars.count; i++) {
-                int err = vector_get(&sb->chars, i, *str + i, sizeof(char));
+        size_t words = ds__bitset_word_count(bitset->count);
+        size_t word = from / DS__BITSET_WORD_BITS;
+        uint64_t bits = bitset->words[word] & 
+                        (~(uint64_t)0 << (from % DS__BITSET_WORD_BITS));
+        while (bits == 0) {
+                if (++word == words) {
+                        return DS_NOT_FOUND_ERROR;
+                }
+                bits = bitset->words[word];
+        }
+        *bit = word * DS__BITSET_WORD_BITS + ds__ctz64(bits);
+        return DS_NO_ERROR;
+}
+
+// dst = dst op src, growing dst to the size of src first when grow is set
+//
+// returns 0 if no error
+static int ds__bitset_combine(struct bitset_t *dst, 
+                              const struct bitset_t *src,
+                              enum ds__bitset_op_enum op, int grow) {
+        if (dst == NULL || src == NULL) {
+                return DS_ARGUMENT_ERROR;
+        }
+        if (grow && src->count > dst->count) {
+                int err = bitset_resize(dst, src->count);
                 if (err) {
                         return err;
                 }
         }
-        (*str)[sb->chars.count] = 0;
 
-        return 0;
+        size_t dst_words = ds__bitset_word_count(dst->count);
+        size_t src_words = ds__bitset_word_count(src->count);
+        size_t n = dst_words < src_words ? dst_words : src_words;
+        ds__bitset_words(dst->words, src->words, n, op);
+        if (op == DS__BITSET_AND && dst_words > n) {
+                // src has no bits there, so neither has the result
+                memset(dst->words + n, 0, (dst_words - n) * sizeof(uint64_t));
+        }
+        return DS_NO_ERROR;
 }
 
-// delete the string builder
-int string_builder_delete(struct string_builder_t *sb) {
-        if (sb == NULL) {
-                return DS_ARGUMENT_ERROR;
-        }
-        return vector_delete(&sb->chars);
+// keep the bits of dst that are also in src
+//
+// returns 0 if no error
+int bitset_and_with(struct bitset_t *dst, const struct bitset_t *src) {
+        return ds__bitset_combine(dst, src, DS__BITSET_AND, 0);
 }
 
-// get the character at a given index
-// 
-// returns 0 if nothing goes wrong
-int string_builder_get(struct string_builder_t *sb, int index, char *ch) {
-        if (sb == NULL || ch == NULL) {
+// add the bits of src to dst
+//
+// returns 0 if no error
+int bitset_or_with(struct bitset_t *dst, const struct bitset_t *src) {
+        return ds__bitset_combine(dst, src, DS__BITSET_OR, 1);
+}
+
+// flip the bits of dst that are in src
+//
+// returns 0 if no error
+int bitset_xor_with(struct bitset_t *dst, const struct bitset_t *src) {
+        return ds__bitset_combine(dst, src, DS__BITSET_XOR, 1);
+}
+
+// remove the bits of src from dst
+//
+// returns 0 if no error
+int bitset_andnot_with(struct bitset_t *dst, const struct bitset_t *src) {
+        return ds__bitset_combine(dst, src, DS__BITSET_ANDNOT, 0);
+}
+
+// delete the bitset
+//
+// frees the words
+int bitset_delete(struct bitset_t *bitset) {
+        if (bitset == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
-        return vector_get(&sb->chars, index, (void*)&ch, sizeof(char));
+
+        DS__FREE(bitset, bitset->words, bitset->capacity * sizeof(uint64_t));
+        return bitset_init_alloc(bitset, bitset->allocator);
 }
 
-// set the character at a given index
+// get the counters of the bitset
 //
-// returns -1 if something went wrong
-int string_builder_set(struct string_builder_t *sb, int index, char ch) {
-        if (sb == NULL) {
+// all zeros unless DS_STATS is defined
+// returns 0 if no error
+int bitset_stats(struct bitset_t *bitset, struct ds_stats_t *stats) {
+        if (bitset == NULL || stats == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
-        return vector_set(&sb->chars, index, (void*)&ch, sizeof(ch));
+#ifdef DS_STATS
+        *stats = bitset->stats;
+#else
+        memset(stats, 0, sizeof(*stats));
+#endif
+        return DS_NO_ERROR;
 }
 
 int ap_argument_init(struct ap_argument_t *arg, enum ap_argument_enum type,
@@ -476,6 +8695,18 @@ int ap_argument_delete(struct ap_argument_t *arg) {
 
 int ap_parser_init(struct ap_parser_t *parser, const char *program_name, 
                    const char *version, const char *description) {
+        return ap_parser_init_alloc(parser, program_name, version, 
+                                    description, NULL);
+}
+
+// initialize the parser with a custom allocator
+//
+// the allocator is used for the argument list and by ap_parser_usage
+// returns 0 if no error
+int ap_parser_init_alloc(struct ap_parser_t *parser, 
+                         const char *program_name, const char *version, 
+                         const char *description,
+                         const struct ds_allocator_t *allocator) {
         if (parser == NULL || program_name == NULL || version == NULL || 
             description == NULL) {
                 return DS_ARGUMENT_ERROR;
@@ -484,7 +8715,18 @@ int ap_parser_init(struct ap_parser_t *parser, const char *program_name,
         parser->program_name = program_name;
         parser->version = version;
         parser->description = description;
-        return vector_init(&parser->arguments);
+        parser->allocator = allocator;
+        parser->indexed = 0;
+        int err = hash_map_init_alloc(&parser->index, 
+                                      sizeof(struct string_view_t),
+                                      sizeof(struct ap_argument_t *),
+                                      ds_hash_string_view, 
+                                      ds_equal_string_view, allocator);
+        if (err) {
+                return err;
+        }
+        return vector_init_alloc(&parser->arguments, 
+                                 sizeof(struct ap_argument_t *), allocator);
 }
 
 int ap_parser_add_argument(struct ap_parser_t *parser, 
@@ -496,45 +8738,156 @@ int ap_parser_add_argument(struct ap_parser_t *parser,
         return vector_append(&parser->arguments, &argument, sizeof(argument));
 }
 
+// add a name of an argument to the index
+//
+// the first argument registered with a name wins
+static int ds__ap_parser_index_name(struct ap_parser_t *parser, 
+                                    const char *name,
+                                    struct ap_argument_t *argument) {
+        if (name == NULL) {
+                return DS_NO_ERROR;
+        }
+        struct string_view_t key = { name, (int)strlen(name) };
+        if (hash_map_find(&parser->index, &key) != NULL) {
+                return DS_NO_ERROR;
+        }
+        return hash_map_put(&parser->index, &key, &argument);
+}
+
+// index the arguments added since the last parse
+//
+// returns 0 if no error
+static int ds__ap_parser_update_index(struct ap_parser_t *parser) {
+        if (parser->indexed == parser->arguments.count) {
+                return DS_NO_ERROR;
+        }
+
+        int err = hash_map_reserve(&parser->index, 
+                                   2 * parser->arguments.count);
+        if (err) {
+                return err;
+        }
+        for (int i = parser->indexed; i < parser->arguments.count; i++) {
+                struct ap_argument_t *argument;
+                err = vector_get(&parser->arguments, i, (void*)&argument, 
+                                 sizeof(argument));
+                if (err) {
+                        return err;
+                }
+                err = ds__ap_parser_index_name(parser, argument->short_name,
+                                               argument);
+                if (err) {
+                        return err;
+                }
+                err = ds__ap_parser_index_name(parser, argument->long_name,
+                                               argument);
+                if (err) {
+                        return err;
+                }
+        }
+        parser->indexed = parser->arguments.count;
+        return DS_NO_ERROR;
+}
+
+// find the argument registered with the first len characters of name
+//
+// returns NULL if there is none
+static struct ap_argument_t *ds__ap_parser_lookup(struct ap_parser_t *parser,
+                                                  const char *name, int len) {
+        struct string_view_t key = { name, len };
+        struct ap_argument_t **argument = hash_map_find(&parser->index, &key);
+        return argument ? *argument : NULL;
+}
+
+// parse the command line arguments
+//
+// the arguments are looked up in a hash index built on the first parse,
+// so parsing is linear in argc
+// besides exact names, "--name=value" and bundled short flags like "-abc"
+// (where the last one may take the rest of the token or the next token
+// as its value) are accepted
+// parsing stops at the first unknown token
+// returns 0 if every token was parsed
 int ap_parser_parse(struct ap_parser_t *parser, int argc, const char **argv) {
         if (parser == NULL || argv == NULL) {
                 return DS_ARGUMENT_ERROR;
         }
 
+        int err = ds__ap_parser_update_index(parser);
+        if (err) {
+                return err;
+        }
+
         int i = 1;
         while (i < argc) {
-                char found = 0;
-                for (int j = 0; j < parser->arguments.count; j++) {
-                        struct ap_argument_t *argument;
-                        int err = vector_get(&parser->arguments, j,
-                                             (void*)&argument, 
-                                             sizeof(argument));
-                        if (err) {
-                                return err;
-                        }
+                const char *token = argv[i];
+                int len = (int)strlen(token);
 
-                        if ((argument->short_name != NULL && 
-                            strcmp(argv[i], argument->short_name) == 0) ||
-                            (argument->long_name != NULL &&
-                            strcmp(argv[i], argument->long_name) == 0)) {
-                                argument->is_exists = 1;
-                                if (argument->type == AP_FLAG) {
-                                        i++;
-                                } else {
-                                        if (i + 1 >= argc) {
-                                                return DS_EXPECTED_ERROR;
-                                        }
-                                        argument->value = argv[i + 1];
-                                        i += 2;
+                struct ap_argument_t *argument = 
+                        ds__ap_parser_lookup(parser, token, len);
+                if (argument != NULL) {
+                        argument->is_exists = 1;
+                        if (argument->type == AP_FLAG) {
+                                i++;
+                        } else {
+                                if (i + 1 >= argc) {
+                                        return DS_EXPECTED_ERROR;
                                 }
-                                found = 1;
+                                argument->value = argv[i + 1];
+                                i += 2;
+                        }
+                        continue;
+                }
+
+                if (token[0] != '-' || token[1] == 0) {
+                        break;
+                }
+
+                // --name=value
+                if (token[1] == '-') {
+                        const char *equal = strchr(token, '=');
+                        if (equal == NULL) {
+                                break;
+                        }
+                        argument = ds__ap_parser_lookup(parser, token, 
+                                                        (int)(equal - token));
+                        if (argument == NULL || argument->type != AP_FVALUE) {
                                 break;
                         }
+                        argument->is_exists = 1;
+                        argument->value = equal + 1;
+                        i++;
+                        continue;
                 }
 
-                if (!found) {
+                // -abc, every character is a short name
+                char name[2] = { '-', 0 };
+                int k = 1;
+                for (; k < len; k++) {
+                        name[1] = token[k];
+                        argument = ds__ap_parser_lookup(parser, name, 2);
+                        if (argument == NULL) {
+                                break;
+                        }
+                        argument->is_exists = 1;
+                        if (argument->type == AP_FVALUE) {
+                                break;
+                        }
+                }
+                if (argument == NULL) {
                         break;
                 }
+                if (argument->type == AP_FVALUE) {
+                        if (k + 1 < len) {
+                                argument->value = token + k + 1;
+                        } else {
+                                if (i + 1 >= argc) {
+                                        return DS_EXPECTED_ERROR;
+                                }
+                                argument->value = argv[++i];
+                        }
+                }
+                i++;
         }
 
         if (i == argc) {
@@ -558,7 +8911,7 @@ int ap_parser_usage(struct ap_parser_t *parser) {
                 }
 
                 struct string_builder_t sb;
-                string_builder_init(&sb);
+                string_builder_init_alloc(&sb, parser->allocator);
                 string_builder_append(&sb, "  ");
                 if (argument->short_name != NULL) {
                         string_builder_append(&sb, argument->short_name);
@@ -572,13 +8925,12 @@ int ap_parser_usage(struct ap_parser_t *parser) {
                 if (argument->type == AP_FVALUE) {
                         string_builder_append(&sb, " <value>");
                 }
-                char *str;
-                string_builder_build(&sb, &str);
+                const char *str;
+                string_builder_cstr(&sb, &str);
         
                 printf("%-40s  ; %s\n", str, argument->description);
 
                 string_builder_delete(&sb);
-                free(str);
         }
         return DS_NO_ERROR;
 }
@@ -588,6 +8940,8 @@ int ap_parser_delete(struct ap_parser_t *parser) {
                 return DS_ARGUMENT_ERROR;
         }
 
+        parser->indexed = 0;
+        hash_map_delete(&parser->index);
         return vector_delete(&parser->arguments);
 }
 
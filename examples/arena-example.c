@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct ds_arena_t arena;
+
+        // initialize the arena with the default block size
+        ds_arena_init(&arena, 0);
+
+        // remember where the "request" starts
+        struct ds_arena_mark_t mark;
+        ds_arena_mark(&arena, &mark);
+
+        for (int request = 0; request < 3; request++) {
+                // containers allocate from the arena
+                struct vector_t vector;
+                vector_init_alloc(&vector, sizeof(int), &arena.allocator);
+
+                struct string_builder_t sb;
+                string_builder_init_alloc(&sb, &arena.allocator);
+
+                for (int i = 0; i < 100; i++) {
+                        int value = request * 100 + i;
+                        vector_append(&vector, &value, sizeof(value));
+                }
+
+                int last;
+                vector_top(&vector, &last, sizeof(last));
+                string_builder_appendf(&sb, "request %d: %d items, last %d",
+                                       request, vector.count, last);
+
+                char *str;
+                string_builder_build(&sb, &str);
+                printf("%s\n", str);
+
+                // no need to delete anything, release the whole request
+                ds_arena_reset(&arena, &mark);
+        }
+
+        ds_arena_delete(&arena);
+
+        return 0;
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct bitset_t primes, odd;
+        bitset_init(&primes);
+        bitset_init(&odd);
+
+        // sieve of eratosthenes, composite numbers are set
+        int limit = 100;
+        bitset_resize(&primes, limit);
+        for (int i = 2; i * i < limit; i++) {
+                int composite;
+                bitset_test(&primes, i, &composite);
+                for (int j = i * i; !composite && j < limit; j += i) {
+                        bitset_set(&primes, j);
+                }
+        }
+        // flip so that primes are set, then drop 0 and 1
+        struct bitset_t all;
+        bitset_init(&all);
+        bitset_resize(&all, limit);
+        for (int i = 0; i < limit; i++) {
+                bitset_set(&all, i);
+        }
+        bitset_xor_with(&primes, &all);
+        bitset_clear(&primes, 0);
+        bitset_clear(&primes, 1);
+
+        size_t count;
+        bitset_count(&primes, &count);
+        printf("%zu primes below %d:", count, limit);
+        size_t bit = 0;
+        while (bitset_find_next_set(&primes, bit, &bit) == DS_NO_ERROR) {
+                printf(" %zu", bit);
+                bit++;
+        }
+        printf("\n");
+
+        // rank is the number of set bits before a position
+        size_t rank;
+        bitset_rank(&primes, 50, &rank);
+        printf("%zu primes below 50\n", rank);
+
+        // bulk operations work on whole words
+        for (int i = 1; i < limit; i += 2) {
+                bitset_set(&odd, i);
+        }
+        bitset_andnot_with(&primes, &odd);
+        bitset_count(&primes, &count);
+        printf("%zu even primes\n", count);
+
+        bitset_delete(&all);
+        bitset_delete(&odd);
+        bitset_delete(&primes);
+        return 0;
+}
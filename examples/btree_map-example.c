@@ -0,0 +1,72 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+static int compare_int(const void *a, const void *b) {
+        int x = *(const int *)a;
+        int y = *(const int *)b;
+        return (x > y) - (x < y);
+}
+
+int main() {
+        struct btree_map_t map;
+        btree_map_init(&map, sizeof(int), sizeof(double), compare_int);
+
+        // keys come back in order whatever order they were put in
+        for (int i = 0; i < 20; i++) {
+                int key = (i * 7) % 20;
+                double value = key * 0.5;
+                btree_map_put(&map, &key, &value);
+        }
+        int key = 6;
+        btree_map_remove(&map, &key);
+
+        double value;
+        key = 13;
+        btree_map_get(&map, &key, &value);
+        printf("%d -> %.1f, %d keys\n", key, value, map.count);
+
+        // range scan of the keys in [5, 10)
+        struct btree_iterator_t it;
+        void *found, *found_value;
+        key = 5;
+        printf("range [5, 10):");
+        int err = btree_map_lower_bound(&map, &key, &it, &found, 
+                                        &found_value);
+        while (err == DS_NO_ERROR && *(int *)found < 10) {
+                printf(" %d=%.1f", *(int *)found, *(double *)found_value);
+                err = btree_map_next(&it, &found, &found_value);
+        }
+        printf("\n");
+
+        // walk backwards from the largest key
+        printf("last three:");
+        err = btree_map_last(&map, &it, &found, NULL);
+        for (int i = 0; i < 3 && err == DS_NO_ERROR; i++) {
+                printf(" %d", *(int *)found);
+                err = btree_map_prev(&it, &found, NULL);
+        }
+        printf("\n");
+
+        // sorted input can be loaded in one go
+        btree_map_clear(&map);
+        int keys[1000];
+        double values[1000];
+        for (int i = 0; i < 1000; i++) {
+                keys[i] = i * 2;
+                values[i] = i;
+        }
+        btree_map_bulk_load(&map, keys, values, 1000);
+        key = 999;
+        err = btree_map_lower_bound(&map, &key, &it, &found, NULL);
+        printf("first key >= %d is %d\n", key, *(int *)found);
+
+        key = 7;
+        err = btree_map_remove(&map, &key);
+        printf("removing a missing key: ");
+        ds_print_error(err);
+
+        btree_map_delete(&map);
+        return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct deque_t deque;
+        deque_init(&deque, sizeof(int));
+
+        // push at both ends
+        for (int i = 1; i <= 3; i++) {
+                deque_push_back(&deque, &i, sizeof(i));
+                int negative = -i;
+                deque_push_front(&deque, &negative, sizeof(negative));
+        }
+        printf("deque:");
+        for (int i = 0; i < deque.count; i++) {
+                int value;
+                deque_get(&deque, i, &value, sizeof(value));
+                printf(" %d", value);
+        }
+        printf("\n");
+
+        // a sliding window of the last 4 values of a stream
+        deque_clear(&deque);
+        int stream[10] = { 5, 1, 4, 1, 5, 9, 2, 6, 5, 3 };
+        for (int i = 0; i < 10; i++) {
+                deque_push_back(&deque, &stream[i], sizeof(int));
+                if (deque.count > 4) {
+                        deque_pop_front(&deque, NULL, sizeof(int));
+                }
+        }
+        int front, back;
+        deque_front(&deque, &front, sizeof(front));
+        deque_back(&deque, &back, sizeof(back));
+        printf("window goes from %d to %d\n", front, back);
+
+        // batches for a work queue
+        deque_push_back_many(&deque, stream, 10, sizeof(int));
+        int batch[6];
+        int popped;
+        deque_pop_front_many(&deque, batch, 6, sizeof(int), &popped);
+        printf("took %d items, %d left\n", popped, deque.count);
+
+        while (deque_pop_back(&deque, NULL, sizeof(int)) == DS_NO_ERROR) {
+        }
+        int err = deque_pop_front(&deque, &front, sizeof(front));
+        printf("popping an empty deque: ");
+        ds_print_error(err);
+
+        deque_delete(&deque);
+        return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct hash_map_t map;
+
+        // int keys to double values, hashed and compared bytewise
+        hash_map_init(&map, sizeof(int), sizeof(double), NULL, NULL);
+
+        // insert some values
+        for (int i = 0; i < 10; i++) {
+                double value = i * 1.5;
+                hash_map_put(&map, &i, &value);
+        }
+
+        // overwrite a value
+        int key = 3;
+        double value = 100;
+        hash_map_put(&map, &key, &value);
+
+        // get values
+        for (int i = 0; i < 10; i++) {
+                hash_map_get(&map, &i, &value);
+                printf("%d => %.1f\n", i, value);
+        }
+
+        // remove a key
+        key = 5;
+        hash_map_remove(&map, &key);
+        int err = hash_map_get(&map, &key, &value);
+        printf("after removing 5: ");
+        ds_print_error(err);
+
+        // iterate over all the items, in no particular order
+        int index = 0;
+        void *k, *v;
+        int count = 0;
+        while (hash_map_next(&map, &index, &k, &v) == DS_NO_ERROR) {
+                count++;
+        }
+        printf("%d items\n", count);
+
+        hash_map_delete(&map);
+
+        // string keys, the map stores the pointers and hashes the strings
+        struct hash_map_t words;
+        hash_map_init(&words, sizeof(const char *), sizeof(int), 
+                      ds_hash_cstr, ds_equal_cstr);
+
+        const char *text[] = { "a", "b", "a", "c", "b", "a" };
+        for (int i = 0; i < 6; i++) {
+                int *seen = hash_map_find(&words, &text[i]);
+                if (seen != NULL) {
+                        (*seen)++;
+                } else {
+                        int one = 1;
+                        hash_map_put(&words, &text[i], &one);
+                }
+        }
+
+        const char *word = "a";
+        int seen;
+        hash_map_get(&words, &word, &seen);
+        printf("'a' was seen %d times\n", seen);
+
+        hash_map_delete(&words);
+
+        return 0;
+}
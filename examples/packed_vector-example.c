@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <string.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct packed_vector_t names;
+        packed_vector_init(&names);
+
+        // every name is stored back to back in one buffer
+        const char *list[] = { "ada", "grace", "linus", "margaret", "ken" };
+        for (int i = 0; i < 5; i++) {
+                packed_vector_append(&names, list[i], strlen(list[i]) + 1);
+        }
+        printf("%d names in %zu bytes\n", names.count, names.used);
+
+        // a shorter name is written in place, a longer one moves to the end
+        packed_vector_set(&names, 1, "bob", 4);
+        packed_vector_set(&names, 4, "kenneth", 8);
+        printf("dead bytes after set: %zu\n", names.dead);
+
+        // get copies the item, the size has to match
+        char name[16];
+        int err = packed_vector_get(&names, 0, name, 3);
+        printf("getting 'ada' with the wrong size: ");
+        ds_print_error(err);
+        packed_vector_get(&names, 0, name, 4);
+        printf("0-th name: %s\n", name);
+
+        packed_vector_compact(&names);
+        printf("after compaction: %zu bytes, %zu dead\n", names.used, 
+               names.dead);
+
+        // at gives the item in place along with its size
+        for (int i = 0; i < names.count; i++) {
+                char *item;
+                int size;
+                packed_vector_at(&names, i, (void **)&item, &size);
+                printf("%d-th name: %s (%d bytes)\n", i, item, size);
+        }
+
+        packed_vector_delete(&names);
+        return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+struct task_t {
+        int priority;
+        const char *name;
+};
+
+// smaller priorities come out first
+int compare_task(const void *a, const void *b) {
+        const struct task_t *x = a;
+        const struct task_t *y = b;
+        return (x->priority > y->priority) - (x->priority < y->priority);
+}
+
+int main() {
+        struct priority_queue_t queue;
+        priority_queue_init(&queue, sizeof(struct task_t), compare_task);
+
+        // build the heap from a batch in one go
+        struct task_t tasks[4] = {
+                { 30, "write report" },
+                { 10, "fix build" },
+                { 50, "clean desk" },
+                { 20, "review patch" },
+        };
+        priority_queue_heapify(&queue, tasks, 4, sizeof(struct task_t));
+
+        struct task_t task = { 40, "answer mail" };
+        int mail;
+        priority_queue_push(&queue, &task, sizeof(task), &mail);
+
+        // the mail turned out to be urgent
+        priority_queue_get(&queue, mail, &task, sizeof(task));
+        task.priority = 5;
+        priority_queue_update(&queue, mail, &task, sizeof(task));
+
+        // the desk can stay messy, handles from heapify follow the batch
+        priority_queue_remove(&queue, 2);
+
+        priority_queue_peek(&queue, &task, sizeof(task));
+        printf("next up: %s\n", task.name);
+
+        while (priority_queue_pop(&queue, &task, sizeof(task)) == 
+               DS_NO_ERROR) {
+                printf("%d: %s\n", task.priority, task.name);
+        }
+
+        int err = priority_queue_pop(&queue, &task, sizeof(task));
+        printf("popping an empty queue: ");
+        ds_print_error(err);
+
+        priority_queue_delete(&queue);
+        return 0;
+}
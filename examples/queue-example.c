@@ -0,0 +1,95 @@
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+#include <pthread.h>
+
+#define NUM_PRODUCERS 4
+#define NUM_ITEMS 100000
+
+struct spsc_queue_t spsc;
+struct mpsc_queue_t mpsc;
+
+void *spsc_producer(void *arg) {
+        (void)arg;
+        int batch[64];
+        int next = 0;
+        while (next < NUM_ITEMS) {
+                int count = 0;
+                for (; count < 64 && next + count < NUM_ITEMS; count++) {
+                        batch[count] = next + count;
+                }
+                int pushed = 0;
+                spsc_queue_push_many(&spsc, batch, count, sizeof(int), 
+                                     &pushed);
+                next += pushed;
+        }
+        return NULL;
+}
+
+void *mpsc_producer(void *arg) {
+        int id = *(int *)arg;
+        for (int i = 0; i < NUM_ITEMS; i++) {
+                int value = id;
+                while (mpsc_queue_push(&mpsc, &value, sizeof(int)) != 
+                       DS_NO_ERROR) {
+                }
+        }
+        return NULL;
+}
+
+int main() {
+        int result = 0;
+        pthread_t producers[NUM_PRODUCERS];
+        int ids[NUM_PRODUCERS];
+
+        // one producer and one consumer, items arrive in order
+        if (spsc_queue_init(&spsc, 1024, sizeof(int)) != DS_NO_ERROR) {
+                printf("failed to initialize the spsc queue\n");
+                return 1;
+        }
+        pthread_create(&producers[0], NULL, spsc_producer, NULL);
+
+        int expected = 0;
+        int batch[64];
+        while (expected < NUM_ITEMS) {
+                int popped = 0;
+                spsc_queue_pop_many(&spsc, batch, 64, sizeof(int), &popped);
+                for (int i = 0; i < popped; i++, expected++) {
+                        if (batch[i] != expected) {
+                                printf("expected %d got %d\n", expected, 
+                                       batch[i]);
+                                result = 1;
+                        }
+                }
+        }
+        pthread_join(producers[0], NULL);
+        printf("spsc: received %d items in order\n", expected);
+        spsc_queue_delete(&spsc);
+
+        // many producers and one consumer
+        if (mpsc_queue_init(&mpsc, 1024, sizeof(int)) != DS_NO_ERROR) {
+                printf("failed to initialize the mpsc queue\n");
+                return 1;
+        }
+        for (int i = 0; i < NUM_PRODUCERS; i++) {
+                ids[i] = i;
+                pthread_create(&producers[i], NULL, mpsc_producer, &ids[i]);
+        }
+
+        int counts[NUM_PRODUCERS] = {0};
+        for (int received = 0; received < NUM_PRODUCERS * NUM_ITEMS;) {
+                int value;
+                if (mpsc_queue_pop(&mpsc, &value, sizeof(int)) == 
+                    DS_NO_ERROR) {
+                        counts[value]++;
+                        received++;
+                }
+        }
+        for (int i = 0; i < NUM_PRODUCERS; i++) {
+                pthread_join(producers[i], NULL);
+                printf("mpsc: producer %d sent %d items\n", i, counts[i]);
+        }
+        mpsc_queue_delete(&mpsc);
+
+        return result;
+}
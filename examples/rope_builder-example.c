@@ -0,0 +1,39 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct rope_builder_t rope;
+
+        // small segments to show how the rope is split
+        rope_builder_init(&rope, 16);
+
+        rope_builder_append(&rope, "hello ");
+        rope_builder_append(&rope, "rope ");
+        for (int i = 0; i < 5; i++) {
+                rope_builder_appendf(&rope, "[%d]", i);
+        }
+        rope_builder_appendc(&rope, '!');
+
+        // join what is buffered
+        char *str;
+        long long length;
+        rope_builder_build(&rope, &str, &length);
+        printf("built %lld chars: '%s'\n", length, str);
+        free(str);
+        rope_builder_delete(&rope);
+
+        // stream a report to stdout, at most 4kb are buffered at a time
+        fflush(stdout);
+        rope_builder_init(&rope, 1024);
+        rope_builder_set_fd(&rope, 1, 4096);
+        for (int i = 0; i < 5; i++) {
+                rope_builder_appendf(&rope, "line %d of the report\n", i);
+        }
+        rope_builder_flush(&rope);
+        printf("streamed %lld chars\n", rope.length);
+        rope_builder_delete(&rope);
+
+        return 0;
+}
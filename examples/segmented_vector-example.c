@@ -0,0 +1,53 @@
+#include <pthread.h>
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+#define NUM_WORKERS 4
+#define NUM_RESULTS 10000
+
+struct segmented_vector_t results;
+
+void *worker(void *arg) {
+        int id = *(int *)arg;
+        for (int i = 0; i < NUM_RESULTS; i++) {
+                int value = id * NUM_RESULTS + i;
+                segmented_vector_append(&results, &value, sizeof(int), NULL);
+        }
+        return NULL;
+}
+
+int main() {
+        segmented_vector_init(&results, sizeof(int));
+
+        // the first item never moves while the workers append
+        int first = -1;
+        int *first_ptr;
+        segmented_vector_append(&results, &first, sizeof(int), NULL);
+        segmented_vector_at(&results, 0, (void **)&first_ptr);
+
+        pthread_t threads[NUM_WORKERS];
+        int ids[NUM_WORKERS];
+        for (int i = 0; i < NUM_WORKERS; i++) {
+                ids[i] = i;
+                pthread_create(&threads[i], NULL, worker, &ids[i]);
+        }
+        for (int i = 0; i < NUM_WORKERS; i++) {
+                pthread_join(threads[i], NULL);
+        }
+
+        int count;
+        segmented_vector_count(&results, &count);
+        long long sum = 0;
+        for (int i = 1; i < count; i++) {
+                int value;
+                segmented_vector_get(&results, i, &value, sizeof(int));
+                sum += value;
+        }
+        printf("collected %d results, sum %lld\n", count - 1, sum);
+        printf("first item is still %d\n", *first_ptr);
+
+        segmented_vector_delete(&results);
+        return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+// count allocations and copies, must come before including ds.h
+#define DS_STATS
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct vector_t vector;
+        vector_init_fixed(&vector, sizeof(int));
+        for (int i = 0; i < 1000; i++) {
+                vector_append(&vector, &i, sizeof(i));
+        }
+
+        struct vector_t items;
+        vector_init(&items);
+        for (int i = 0; i < 1000; i++) {
+                vector_append(&items, &i, sizeof(i));
+        }
+
+        struct string_builder_t sb;
+        string_builder_init(&sb);
+        for (int i = 0; i < 1000; i++) {
+                string_builder_appendf(&sb, "%d,", i);
+        }
+
+        struct hash_map_t map;
+        hash_map_init(&map, sizeof(int), sizeof(int), NULL, NULL);
+        for (int i = 0; i < 1000; i++) {
+                hash_map_put(&map, &i, &i);
+        }
+
+        // per container counters
+        struct ds_stats_t stats;
+        vector_stats(&vector, &stats);
+        ds_stats_dump(stdout, "fixed vector", &stats);
+        vector_stats(&items, &stats);
+        ds_stats_dump(stdout, "vector", &stats);
+        string_builder_stats(&sb, &stats);
+        ds_stats_dump(stdout, "string builder", &stats);
+        hash_map_stats(&map, &stats);
+        ds_stats_dump(stdout, "hash map", &stats);
+
+        vector_delete(&vector);
+        vector_delete(&items);
+        string_builder_delete(&sb);
+        hash_map_delete(&map);
+
+        // global counters, everything is freed so live_bytes is back to 0
+        ds_stats_dump(stdout, "global", NULL);
+
+        return 0;
+}
@@ -27,6 +27,14 @@ int main() {
         // append some moreeee string
         string_builder_appendf(&sb, " abc-%d", 1000);
 
+        // append numbers without printf
+        string_builder_appendc(&sb, ' ');
+        string_builder_append_int(&sb, -42);
+        string_builder_appendc(&sb, ' ');
+        string_builder_append_hex(&sb, 0xbeef);
+        string_builder_appendc(&sb, ' ');
+        string_builder_append_double(&sb, 0.1);
+
         // get the character at a given index
         char ch = 0;
         string_builder_get(&sb, 0, &ch);
@@ -42,6 +50,52 @@ int main() {
         printf("Result: '%s'\n", res);
         free(res);
 
+        // borrow the contents without copying
+        struct string_view_t view;
+        string_builder_view(&sb, &view);
+        printf("View: '%.*s' (%d chars)\n", view.length, view.data, 
+               view.length);
+
+        const char *cstr;
+        string_builder_cstr(&sb, &cstr);
+        printf("Cstr: '%s'\n", cstr);
+
+        // take the storage, the string builder is empty afterwards
+        char *stolen;
+        int length;
+        string_builder_steal(&sb, &stolen, &length);
+        printf("Stolen: '%s' (%d chars), left in builder: %d\n", stolen, 
+               length, sb.count);
+        free(stolen);
+
+        string_builder_delete(&sb);
+
+        // search, count, replace and split
+        string_builder_init(&sb);
+        string_builder_append(&sb, "name,age,city\nalice,30,paris\n");
+
+        int count;
+        string_builder_count_char(&sb, '\n', &count);
+        printf("lines: %d\n", count);
+
+        int index;
+        string_builder_find(&sb, "alice", 0, &index);
+        printf("'alice' at: %d\n", index);
+
+        int replaced;
+        string_builder_replace(&sb, ",", " | ", &replaced);
+        printf("replaced %d commas\n", replaced);
+
+        struct vector_t lines;
+        vector_init_fixed(&lines, sizeof(struct string_view_t));
+        string_builder_split(&sb, '\n', &lines);
+        for (int i = 0; i < lines.count; i++) {
+                struct string_view_t line;
+                vector_get(&lines, i, &line, sizeof(line));
+                printf("line %d: '%.*s'\n", i, line.length, line.data);
+        }
+        vector_delete(&lines);
+
         string_builder_delete(&sb);
 
         return 0;
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <string.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+int main() {
+        struct string_interner_t interner;
+        string_interner_init(&interner);
+
+        // the same token always gets the same id
+        const char *text = "the cat saw the dog and the dog saw the cat";
+        int ids[16];
+        int count = 0;
+        const char *start = text;
+        while (*start != '\0') {
+                int length = (int)strcspn(start, " ");
+                string_interner_internn(&interner, start, length, 
+                                        &ids[count++]);
+                start += length;
+                start += *start == ' ';
+        }
+
+        printf("ids:");
+        for (int i = 0; i < count; i++) {
+                printf(" %d", ids[i]);
+        }
+        printf("\n");
+
+        int distinct;
+        string_interner_count(&interner, &distinct);
+        printf("%d words, %d distinct\n", count, distinct);
+
+        // comparing words is comparing ids
+        int dog;
+        string_interner_intern(&interner, "dog", &dog);
+        printf("word 4 is dog: %s\n", ids[4] == dog ? "yes" : "no");
+
+        // the views are NUL terminated and stay valid until delete
+        struct string_view_t view;
+        string_interner_get(&interner, ids[1], &view);
+        printf("id %d is '%s' (%d chars)\n", ids[1], view.data, view.length);
+
+        int id;
+        int err = string_interner_lookup(&interner, "bird", 4, &id);
+        printf("looking up bird: ");
+        ds_print_error(err);
+
+        string_interner_delete(&interner);
+        return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+
+#define DS_IMPLEMENTATION
+#include "ds.h"
+
+// generates struct int_vector_t and the int_vector_* functions
+DS_VECTOR_DEFINE(int_vector, int)
+
+struct point_t {
+        double x;
+        double y;
+};
+
+// works with any type that can be assigned
+DS_VECTOR_DEFINE(point_vector, struct point_t)
+
+int main() {
+        struct int_vector_t ints;
+        int_vector_init(&ints);
+
+        // push some values
+        for (int i = 0; i < 10; i++) {
+                int_vector_push(&ints, i * i);
+        }
+
+        // iterate over the raw data, the compiler sees plain ints
+        long sum = 0;
+        int *data = int_vector_data(&ints);
+        for (int i = 0; i < int_vector_count(&ints); i++) {
+                sum += data[i];
+        }
+        printf("sum of squares: %ld\n", sum);
+
+        // checked access
+        int value;
+        int_vector_get(&ints, 3, &value);
+        printf("3-th value: %d\n", value);
+        int err = int_vector_get(&ints, 42, &value);
+        printf("42-th value: ");
+        ds_print_error(err);
+
+        // pop out values
+        while (int_vector_pop(&ints, &value) == DS_NO_ERROR) {
+                printf("popped: %d\n", value);
+        }
+        int_vector_delete(&ints);
+
+        struct point_vector_t points;
+        point_vector_init(&points);
+        for (int i = 0; i < 3; i++) {
+                struct point_t p = { i, i * 2.0 };
+                point_vector_push(&points, p);
+        }
+        point_vector_at(&points, 1)->y = 100;
+        for (int i = 0; i < point_vector_count(&points); i++) {
+                struct point_t *p = point_vector_at(&points, i);
+                printf("point %d: (%.1f, %.1f)\n", i, p->x, p->y);
+        }
+        point_vector_delete(&points);
+
+        return 0;
+}
@@ -4,6 +4,12 @@
 #define DS_IMPLEMENTATION
 #include "ds.h"
 
+int compare_int(const void *a, const void *b) {
+        int x = *(const int *)a;
+        int y = *(const int *)b;
+        return (x > y) - (x < y);
+}
+
 int main() {
         struct vector_t vector;
 
@@ -57,5 +63,93 @@ int main() {
 
         vector_delete(&vector);
 
+        // fixed size vector, items are stored in one contiguous buffer
+        struct vector_t fixed;
+        vector_init_fixed(&fixed, sizeof(double));
+
+        for (int i = 0; i < 10; i++) {
+                double value = i * 0.5;
+                vector_append(&fixed, &value, sizeof(value));
+        }
+
+        for (int i = 0; i < 10; i++) {
+                double value;
+                vector_get(&fixed, i, &value, sizeof(value));
+                printf("%d-th fixed value: %.1f\n", i, value);
+        }
+
+        // items with a different size are rejected
+        int wrong = 0;
+        int err = vector_append(&fixed, &wrong, sizeof(wrong));
+        printf("appending an int to a double vector: ");
+        ds_print_error(err);
+
+        // bulk operations, every call is one range check and one copy
+        double batch[5] = { 10, 20, 30, 40, 50 };
+        vector_append_many(&fixed, batch, 5, sizeof(double));
+        vector_erase(&fixed, 0, 10);
+        double first = -1;
+        vector_insert(&fixed, 0, &first, sizeof(first));
+        vector_resize(&fixed, 8);
+        vector_get_range(&fixed, 0, 5, batch, sizeof(double));
+        printf("after bulk operations (%d items):", fixed.count);
+        for (int i = 0; i < 5; i++) {
+                printf(" %.1f", batch[i]);
+        }
+        printf("\n");
+
+        // reserve space up front, clear and shrink
+        vector_reserve(&fixed, 1000);
+        printf("capacity after reserve: %d\n", fixed.capacity);
+        vector_clear(&fixed);
+        vector_shrink_to_fit(&fixed);
+        printf("capacity after clear and shrink: %d\n", fixed.capacity);
+
+        // sort and search
+        int numbers[8] = { 42, -7, 13, 0, 99, -7, 5, 21 };
+        struct vector_t sorted;
+        vector_init_fixed(&sorted, sizeof(int));
+        vector_append_many(&sorted, numbers, 8, sizeof(int));
+        vector_radix_sort(&sorted, 0, sizeof(int), 1);
+        vector_get_range(&sorted, 0, 8, numbers, sizeof(int));
+        printf("sorted:");
+        for (int i = 0; i < 8; i++) {
+                printf(" %d", numbers[i]);
+        }
+        printf("\n");
+
+        int key = 13;
+        int index;
+        if (vector_bsearch(&sorted, &key, compare_int, &index) == 
+            DS_NO_ERROR) {
+                printf("found %d at %d\n", key, index);
+        }
+        key = 50;
+        vector_lower_bound(&sorted, &key, compare_int, &index);
+        printf("%d would be inserted at %d\n", key, index);
+
+        // save the sorted vector and map it back without copying
+        vector_save(&sorted, "vector-example.bin");
+        vector_delete(&sorted);
+
+        struct vector_t mapped;
+        vector_open(&mapped, "vector-example.bin", VECTOR_MAP_VERIFY);
+        vector_get(&mapped, 0, &key, sizeof(int));
+        printf("mapped %d items, first is %d\n", mapped.count, key);
+        err = vector_set(&mapped, 0, &key, sizeof(int));
+        printf("writing to a read only mapping: ");
+        ds_print_error(err);
+        vector_delete(&mapped);
+
+        // copy on write mappings can be changed, the file stays the same
+        vector_open(&mapped, "vector-example.bin", VECTOR_MAP_COPY_ON_WRITE);
+        key = 1000;
+        vector_append(&mapped, &key, sizeof(int));
+        printf("copy on write vector has %d items\n", mapped.count);
+        vector_delete(&mapped);
+        remove("vector-example.bin");
+
+        vector_delete(&fixed);
+
         return 0;
 }